@@ -0,0 +1,182 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "engine.h"
+#include "render.h"
+
+/* 엔진 핫패스 마이크로벤치마크 (make bench)
+ * 고정 시드로 실제 게임 중간 상태를 여러 개 만들어 두고, 함수마다 그 상태들을
+ * 돌아가며 호출한다. 반복 횟수는 최소 시간을 넘길 때까지 두 배씩 늘린다.
+ * 결과는 한 줄에 하나씩 CSV로 내보내서 릴리스끼리 비교할 수 있게 한다. */
+#define BENCH_SEED 0x7E7215ULL
+#define BENCH_STATES 256                /* 2의 거듭제곱 */
+#define BENCH_MIN_MS 200
+
+static struct game_state states[BENCH_STATES];
+static struct game_state line_states[BENCH_STATES];
+static struct game_state lock_states[BENCH_STATES];
+static volatile long sink;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* 굳히기용: 고스트 자리에 내린 블록이 걸친 줄 중 아래에서 lines줄을 블록 칸만 빼고
+ * 채워 둔다. 굳히면 블록이 그 줄들을 직접 채워서 정리된다 */
+static void make_lock_state(struct game_state *out, const struct game_state *g, int lines) {
+    int row;
+
+    *out = *g;
+    out->y = out->ghost_y;
+    for(row = out->y + 3; row >= out->y && lines > 0; row--) {
+        row_t piece = piece_row(out->block_number, out->block_state, out->x, out->y, row);
+        if(piece == 0 || row < 0 || row >= BOARD_HEIGHT) continue;
+        out->tetris_table[row] |= FULL_ROW & ~piece;
+        lines--;
+    }
+    update_heights(out);
+    calculate_ghost_position(out);
+}
+
+/* 무작위로 몇 칸 옮기고 돌린 뒤 하드 드롭하기를 반복해서 보드를 쌓는다.
+ * 상태마다 쌓은 블록 수가 달라서 빈 보드부터 꽤 찬 보드까지 고르게 섞인다 */
+static void make_states(void) {
+    uint64_t rng = BENCH_SEED;
+    int i, k;
+
+    for(i = 0; i < BENCH_STATES; i++) {
+        struct game_state *g = &states[i];
+        int pieces = i % 40;
+
+        game_init(g, BENCH_SEED + i, RANDOMIZER_BAG);
+        for(k = 0; k < pieces && g->game == GAME_START; k++) {
+            int moves = (int)rng_below(&rng, 5) - 2;
+            int turns = (int)rng_below(&rng, 4);
+
+            while(turns-- > 0) move_block(g, ROTATE);
+            for(; moves < 0; moves++) move_block(g, LEFT);
+            for(; moves > 0; moves--) move_block(g, RIGHT);
+            drop(g);
+        }
+        /* 게임이 끝난 보드는 다시 비워서 계속 쓸 수 있게 */
+        if(g->game != GAME_START) game_init(g, BENCH_SEED + i, RANDOMIZER_BAG);
+        ghost_rf(g);
+
+        /* check_one_line용: 바닥에서 0~4줄을 채워 둔 복사본 */
+        line_states[i] = *g;
+        for(k = 0; k < i % 5; k++)
+            line_states[i].tetris_table[BOARD_HEIGHT - 1 - k] = FULL_ROW;
+        update_heights(&line_states[i]);
+        calculate_ghost_position(&line_states[i]);
+
+        make_lock_state(&lock_states[i], g, i % 5);
+    }
+}
+
+/* 벤치마크 하나. 상태 번호 n을 받아 결과를 합산용 값으로 돌려준다 */
+typedef long (*bench_fn)(long n);
+
+static long bench_state_copy(long n) {
+    struct game_state g = states[n & (BENCH_STATES - 1)];
+    return g.x;
+}
+
+static long bench_collision_test(long n) {
+    return collision_test(&states[n & (BENCH_STATES - 1)], (int)(n & 3));
+}
+
+static long bench_check_one_line(long n) {
+    struct game_state g = line_states[n & (BENCH_STATES - 1)];
+    return check_one_line(&g);
+}
+
+static long bench_ghost(long n) {
+    struct game_state *g = &states[n & (BENCH_STATES - 1)];
+    calculate_ghost_position(g);
+    return g->ghost_y;
+}
+
+static long bench_drop(long n) {
+    struct game_state g = states[n & (BENCH_STATES - 1)];
+    drop(&g);
+    return g.point + g.y;
+}
+
+/* 굳히는 경로만: 고스트 위치에 내려 둔 블록을 굳히고 줄 정리 후 다음 블록.
+ * 상태마다 블록이 0~4줄(블록이 걸친 줄 수까지)을 채우게 만들어 둬서 줄 정리까지 탄다 */
+static long bench_lock(long n) {
+    struct game_state g = lock_states[n & (BENCH_STATES - 1)];
+    lock_block(&g);
+    return g.point + g.block_number;
+}
+
+static struct renderer screen;
+
+/* 상태가 매번 바뀌므로 바뀐 칸만 그리는 보통 프레임 */
+static long bench_render_diff(long n) {
+    return (long)render_frame(&screen, &states[n & (BENCH_STATES - 1)], 0);
+}
+
+/* 화면을 지우고 처음부터 그리는 프레임 */
+static long bench_render_full(long n) {
+    render_reset(&screen);
+    return (long)render_frame(&screen, &states[n & (BENCH_STATES - 1)], 0);
+}
+
+struct bench {
+    const char *name;
+    bench_fn fn;
+};
+
+static const struct bench benches[] = {
+    {"state_copy", bench_state_copy},           /* 복사하는 벤치마크의 기준값 */
+    {"collision_test", bench_collision_test},
+    {"check_one_line", bench_check_one_line},   /* 상태 복사 포함 */
+    {"calculate_ghost_position", bench_ghost},
+    {"drop", bench_drop},                       /* 상태 복사, 굳히기 포함 */
+    {"lock_block", bench_lock},                 /* 상태 복사 포함 */
+    {"render_diff", bench_render_diff},
+    {"render_full", bench_render_full},
+};
+
+static double run_bench(bench_fn fn, long iters) {
+    double start = now_ns();
+    long n, acc = 0;
+
+    for(n = 0; n < iters; n++)
+        acc += fn(n);
+    sink += acc;
+    return now_ns() - start;
+}
+
+int main(int argc, char *argv[]) {
+    double min_ns = BENCH_MIN_MS * 1e6;
+    size_t i;
+
+    if(argc > 1) min_ns = atof(argv[1]) * 1e6;
+
+    make_states();
+    render_reset(&screen);
+
+    printf("benchmark,iterations,ns_per_op,ops_per_sec\n");
+    for(i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        long iters = 1024;
+        double elapsed;
+
+        run_bench(benches[i].fn, iters);    /* 캐시 데우기 */
+        while((elapsed = run_bench(benches[i].fn, iters)) < min_ns)
+            iters *= 2;
+
+        printf("%s,%ld,%.2f,%.0f\n", benches[i].name, iters,
+               elapsed / iters, iters / (elapsed / 1e9));
+        fflush(stdout);
+    }
+
+    return 0;
+}
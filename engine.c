@@ -0,0 +1,435 @@
+#include <string.h>
+
+#include "engine.h"
+
+/* 블록 테이블: 칸 좌표로부터 행 마스크, 열별 바닥, 바운딩 박스를 컴파일 타임에 만든다 */
+#define MIN2(a, b) ((a) < (b) ? (a) : (b))
+#define MAX2(a, b) ((a) > (b) ? (a) : (b))
+#define MIN4(a, b, c, d) MIN2(MIN2(a, b), MIN2(c, d))
+#define MAX4(a, b, c, d) MAX2(MAX2(a, b), MAX2(c, d))
+#define ROW_MASK(r, x0, y0, x1, y1, x2, y2, x3, y3) \
+    (((y0) == (r)) << (x0) | ((y1) == (r)) << (x1) | \
+     ((y2) == (r)) << (x2) | ((y3) == (r)) << (x3))
+#define COL_BOTTOM(c, x0, y0, x1, y1, x2, y2, x3, y3) \
+    MAX4((x0) == (c) ? (y0) : -1, (x1) == (c) ? (y1) : -1, \
+         (x2) == (c) ? (y2) : -1, (x3) == (c) ? (y3) : -1)
+#define SHAPE(x0, y0, x1, y1, x2, y2, x3, y3) { \
+    { {x0, y0}, {x1, y1}, {x2, y2}, {x3, y3} }, \
+    { ROW_MASK(0, x0, y0, x1, y1, x2, y2, x3, y3), \
+      ROW_MASK(1, x0, y0, x1, y1, x2, y2, x3, y3), \
+      ROW_MASK(2, x0, y0, x1, y1, x2, y2, x3, y3), \
+      ROW_MASK(3, x0, y0, x1, y1, x2, y2, x3, y3) }, \
+    { COL_BOTTOM(0, x0, y0, x1, y1, x2, y2, x3, y3), \
+      COL_BOTTOM(1, x0, y0, x1, y1, x2, y2, x3, y3), \
+      COL_BOTTOM(2, x0, y0, x1, y1, x2, y2, x3, y3), \
+      COL_BOTTOM(3, x0, y0, x1, y1, x2, y2, x3, y3) }, \
+    MIN4(x0, x1, x2, x3), MAX4(x0, x1, x2, x3), \
+    MIN4(y0, y1, y2, y3), MAX4(y0, y1, y2, y3) }
+
+const struct block_shape block_table[7][4] = {
+    {   /* I_BLOCK */
+        SHAPE(0,0, 1,0, 2,0, 3,0),
+        SHAPE(3,0, 3,1, 3,2, 3,3),
+        SHAPE(0,3, 1,3, 2,3, 3,3),
+        SHAPE(0,0, 0,1, 0,2, 0,3)
+    },
+    {   /* T_BLOCK */
+        SHAPE(0,0, 0,1, 1,1, 0,2),
+        SHAPE(0,0, 1,0, 2,0, 1,1),
+        SHAPE(2,0, 1,1, 2,1, 2,2),
+        SHAPE(1,1, 0,2, 1,2, 2,2)
+    },
+    {   /* S_BLOCK */
+        SHAPE(0,0, 0,1, 1,1, 1,2),
+        SHAPE(1,0, 2,0, 0,1, 1,1),
+        SHAPE(0,0, 0,1, 1,1, 1,2),
+        SHAPE(1,0, 2,0, 0,1, 1,1)
+    },
+    {   /* Z_BLOCK */
+        SHAPE(1,0, 0,1, 1,1, 0,2),
+        SHAPE(0,0, 1,0, 1,1, 2,1),
+        SHAPE(1,0, 0,1, 1,1, 0,2),
+        SHAPE(0,0, 1,0, 1,1, 2,1)
+    },
+    {   /* L_BLOCK */
+        SHAPE(0,0, 0,1, 0,2, 1,2),
+        SHAPE(0,0, 1,0, 2,0, 0,1),
+        SHAPE(1,0, 2,0, 2,1, 2,2),
+        SHAPE(2,1, 0,2, 1,2, 2,2)
+    },
+    {   /* J_BLOCK */
+        SHAPE(1,0, 1,1, 0,2, 1,2),
+        SHAPE(0,0, 0,1, 1,1, 2,1),
+        SHAPE(1,0, 2,0, 1,1, 1,2),
+        SHAPE(0,1, 1,1, 2,1, 2,2)      //회전이 이상하게 되어있음
+    },
+    {   /* O_BLOCK */
+        SHAPE(0,0, 1,0, 0,1, 1,1),
+        SHAPE(0,0, 1,0, 0,1, 1,1),
+        SHAPE(0,0, 1,0, 0,1, 1,1),
+        SHAPE(0,0, 1,0, 0,1, 1,1)
+    }
+};
+
+/* 블록을 레이어에 그리기 (화면 밖은 잘라냄) */
+static void stamp_block(row_t *layer, int block, int state, int bx, int by) {
+    const struct block_shape *shape = &block_table[block][state];
+    int i;
+    for(i = shape->min_y; i <= shape->max_y; i++) {
+        int row = by + i;
+        if(row >= 0 && row < BOARD_HEIGHT)
+            layer[row] |= ROW_BITS(shape->row_mask[i], bx) & FIELD_MASK;
+    }
+}
+
+int init_tetris_table(struct game_state *g) {
+    int i;
+    for(i = 0; i < BOARD_HEIGHT; i++)
+        g->tetris_table[i] = EMPTY_ROW;
+    for(i = BOARD_HEIGHT; i < BOARD_ROWS; i++)
+        g->tetris_table[i] = FULL_ROW;
+    update_heights(g);
+    return 0;
+}
+
+/* splitmix64: 상태 64비트 하나로 충분히 고른 난수를 낸다 */
+uint64_t rng_next(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* [0, n) 균등 난수. 나머지가 치우치는 구간은 버리고 다시 뽑는다 */
+uint32_t rng_below(uint64_t *state, uint32_t n) {
+    uint32_t limit = (uint32_t)-n % n;     /* 2^32 mod n */
+    uint32_t r;
+    do {
+        r = (uint32_t)(rng_next(state) >> 32);
+    } while(r < limit);
+    return r % n;
+}
+
+/* 다음에 나올 블록 번호 */
+int next_piece(struct game_state *g) {
+    if(g->randomizer == RANDOMIZER_BAG) {
+        if(g->bag_left == 0) {
+            int i;
+            for(i = 0; i < 7; i++)
+                g->bag[i] = (unsigned char)i;
+            for(i = 6; i > 0; i--) {
+                int j = (int)rng_below(&g->rng, (uint32_t)i + 1);
+                unsigned char t = g->bag[i];
+                g->bag[i] = g->bag[j];
+                g->bag[j] = t;
+            }
+            g->bag_left = 7;
+        }
+        return g->bag[--g->bag_left];
+    }
+    return (int)rng_below(&g->rng, 7);
+}
+
+/* 새 게임 준비. 같은 seed와 randomizer면 블록 순서도 같다 */
+void game_init(struct game_state *g, uint64_t seed, int randomizer) {
+    init_tetris_table(g);
+    
+    g->rng = seed;
+    g->randomizer = randomizer;
+    g->bag_left = 0;
+    g->block_number = next_piece(g);
+    g->next_block_number = next_piece(g);
+    
+    g->game = GAME_START;
+    g->point = 0;
+    g->leveling = 0;
+    g->level = 0;
+    g->lines = 0;
+    g->pieces = 0;
+    g->x = SPAWN_X;
+    g->y = 0;
+    g->block_state = 0;
+    g->ghost_y = 0;
+}
+
+/* (block, state)를 (bx, by)에 놓았을 때 벽이나 굳은 블록과 겹치는지 */
+int block_collides(const struct game_state *g, int block, int state, int bx, int by) {
+    const struct block_shape *shape;
+    int i;
+    
+    if(block < I_BLOCK || block > O_BLOCK) return 1;
+    
+    shape = &block_table[block][state];
+    for(i = shape->min_y; i <= shape->max_y; i++) {
+        row_t bits = ROW_BITS(shape->row_mask[i], bx);
+        int row = i + by;
+        
+        /* 보드 위쪽은 벽하고만 충돌 검사 */
+        if(row < 0) {
+            if(bits & EMPTY_ROW) return 1;
+        } else if(bits & g->tetris_table[row]) {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+int collision_test(const struct game_state *g, int command) {
+    (void)command;
+
+    return block_collides(g, g->block_number, g->block_state, g->x, g->y);
+}
+
+int move_block(struct game_state *g, int command) {
+    int old_x = g->x;
+    int old_y = g->y;
+    int old_block_state = g->block_state;
+    
+    switch(command) {
+        case LEFT:
+            g->x--;
+            break;
+        case RIGHT:
+            g->x++;
+            break;
+        case DOWN:
+            g->y++;
+            break;
+        case ROTATE:
+            g->block_state = (g->block_state + 1) % 4;
+            break;
+    }
+    
+    if(collision_test(g, command) == 1) {
+        g->x = old_x;
+        g->y = old_y;
+        g->block_state = old_block_state;
+        
+        if(command == DOWN) {
+            lock_block(g);
+        }
+        
+        return 1;
+    }
+    
+    return 0;
+}
+
+/* 20G: 떠 있는 블록은 바로 바닥까지 (굳히지는 않음) */
+static void settle_20g(struct game_state *g) {
+    if(g->leveling && g->level >= MAX_LEVEL && g->game == GAME_START &&
+       collision_test(g, DOWN) == 0)
+        g->y = landing_y(g);
+}
+
+/* 플레이어 입력 하나 처리. 화면 게임과 리플레이가 같은 경로를 탄다 */
+int game_command(struct game_state *g, int command) {
+    int ret;
+
+    switch(command) {
+        case LEFT:
+        case RIGHT:
+        case DOWN:
+        case ROTATE:
+            ret = move_block(g, command);
+            settle_20g(g);
+            return ret;
+        case HARD_DROP:
+            return drop(g);
+        case QUIT:
+            g->game = GAME_END;
+            return 0;
+    }
+    return 1;
+}
+
+/* 레벨별 중력 간격 (us). 0레벨은 예전 속도, 1~19는 가이드라인 곡선
+ * (0.8 - 0.007 * level)^level 초, 20G는 굳기까지의 시간 */
+static const long gravity_table[MAX_LEVEL + 1] = {
+    990000, 793000, 617796, 472729, 355197, 262004, 189677, 134735,
+    93882, 64152, 42976, 28218, 18153, 11439, 7059, 4264,
+    2520, 1457, 824, 455, 500000
+};
+
+long gravity_interval_us(const struct game_state *g) {
+    return gravity_table[g->leveling ? g->level : 0];
+}
+
+/* 중력으로 한 칸. 바닥이면 굳히고 1 (20G에서는 늘 바닥이라 바로 굳는다) */
+int gravity_step(struct game_state *g) {
+    return move_block(g, DOWN);
+}
+
+int drop(struct game_state *g) {
+    if(collision_test(g, DOWN) == 0)
+        g->y = landing_y(g);
+    else
+        g->y--;     // 이미 겹쳐 있으면 예전처럼 한 칸 위에서 굳힌다
+    move_block(g, DOWN);
+    
+    return 0;
+}
+
+/* lo~hi행 중 꽉 찬 줄을 지우고 점수를 더한다. 지운 줄 수 반환.
+ * 행이 워드 하나라 꽉 찼는지는 비교 한 번이고, 지울 때는 가장 아래 꽉 찬 줄부터
+ * 위로 한 번만 훑으며 남는 줄을 아래로 당긴다 (줄마다 memmove하고 다시 훑지 않음) */
+static int clear_lines(struct game_state *g, int lo, int hi) {
+    int i, dst;
+    int line_count = 0;
+    
+    if(lo < 0) lo = 0;
+    if(hi > BOARD_HEIGHT - 1) hi = BOARD_HEIGHT - 1;
+    
+    while(hi >= lo && g->tetris_table[hi] != FULL_ROW)
+        hi--;
+    if(hi < lo) return 0;
+    
+    for(i = dst = hi; i >= 0; i--) {
+        if(i >= lo && g->tetris_table[i] == FULL_ROW) {
+            line_count++;
+            continue;
+        }
+        g->tetris_table[dst--] = g->tetris_table[i];
+    }
+    for(; dst >= 0; dst--)
+        g->tetris_table[dst] = EMPTY_ROW;
+    
+    /* 지운 줄은 모든 열을 덮으니 열 높이는 적어도 line_count만큼 낮아진다.
+     * 거기서부터 내려가며 첫 칸을 찾으면 보통 한 번에 끝난다 */
+    for(i = 1; i <= BOARD_WIDTH; i++) {
+        int row = BOARD_HEIGHT - (g->height[i] - line_count);
+        while(row < BOARD_HEIGHT && !CELL_SET(g->tetris_table[row], i))
+            row++;
+        g->height[i] = (unsigned char)(BOARD_HEIGHT - row);
+    }
+    
+    g->lines += line_count;
+    g->level = g->lines / LEVEL_LINES < MAX_LEVEL ? (int)(g->lines / LEVEL_LINES) : MAX_LEVEL;
+    
+    if(line_count == 1)
+        g->point += 100;
+    else if(line_count == 2)
+        g->point += 300;
+    else if(line_count == 3)
+        g->point += 600;
+    else if(line_count == 4)
+        g->point += 1000;
+    
+    return line_count;
+}
+
+/* 현재 블록을 보드에 굳히고 줄 정리, 지운 줄 수 반환 */
+int place_block(struct game_state *g) {
+    const struct block_shape *shape;
+    int i;
+
+    if(g->block_number < I_BLOCK || g->block_number > O_BLOCK) return 0;
+    
+    stamp_block(g->tetris_table, g->block_number, g->block_state, g->x, g->y);
+
+    /* 굳힌 칸이 열 높이를 넘으면 올려 준다 */
+    shape = &block_table[g->block_number][g->block_state];
+    for(i = 0; i < 4; i++) {
+        int col = g->x + shape->cell[i].x;
+        int row = g->y + shape->cell[i].y;
+        if(row >= 0 && row < BOARD_HEIGHT && col >= 1 && col <= BOARD_WIDTH &&
+           BOARD_HEIGHT - row > g->height[col])
+            g->height[col] = (unsigned char)(BOARD_HEIGHT - row);
+    }
+    
+    /* 꽉 찰 수 있는 건 방금 굳힌 블록이 걸친 줄뿐 */
+    return clear_lines(g, g->y + shape->min_y, g->y + shape->max_y);
+}
+
+/* 굳히고 다음 블록 꺼내기 */
+void lock_block(struct game_state *g) {
+    place_block(g);
+    spawn_block(g);
+}
+
+/* 다음 블록을 시작 위치에 놓고, 놓을 수 없으면 게임 끝 */
+void spawn_block(struct game_state *g) {
+    g->block_number = g->next_block_number;
+    g->next_block_number = next_piece(g);
+    g->block_state = 0;
+    g->x = SPAWN_X;
+    g->y = 0;
+    g->pieces++;
+    
+    if(collision_test(g, DOWN) == 1) {
+        g->game = GAME_END;
+    }
+    settle_20g(g);
+}
+
+/* 보드 전체에서 꽉 찬 줄 정리 */
+int check_one_line(struct game_state *g) {
+    return clear_lines(g, 0, BOARD_HEIGHT - 1);
+}
+
+/* 열 높이를 보드에서 다시 계산. 위에서부터 내려오며 처음 만난 칸이 그 열의 높이 */
+void update_heights(struct game_state *g) {
+    row_t seen = 0;
+    int i;
+
+    memset(g->height, 0, sizeof(g->height));
+    g->height[0] = g->height[RIGHT_WALL] = BOARD_HEIGHT;
+    for(i = 0; i < BOARD_HEIGHT && seen != FIELD_MASK; i++) {
+        row_t fresh = g->tetris_table[i] & FIELD_MASK & ~seen;
+        seen |= fresh;
+        while(fresh) {
+            g->height[ROW_CTZ(fresh) - BOARD_SHIFT] = (unsigned char)(BOARD_HEIGHT - i);
+            fresh &= fresh - 1;
+        }
+    }
+}
+
+/* 현재 블록이 똑바로 떨어져 닿는 y.
+ * 블록이 닿는 열마다 (열 꼭대기 - 1 - 블록의 그 열 바닥) 중 가장 작은 값이다.
+ * 블록이 이미 어떤 열의 꼭대기보다 아래에 있으면 (처마 밑으로 밀어 넣은 경우)
+ * 높이만으로는 알 수 없어서 한 칸씩 내려 본다 */
+int landing_y(const struct game_state *g) {
+    const struct block_shape *shape = &block_table[g->block_number][g->block_state];
+    int land = BOARD_ROWS;
+    int i, y;
+
+    for(i = shape->min_x; i <= shape->max_x; i++) {
+        int col = g->x + i;
+        int top;
+        if(shape->bottom[i] < 0) continue;
+        if(col < 1 || col > BOARD_WIDTH) break;
+        top = BOARD_HEIGHT - g->height[col];
+        if(g->y + shape->bottom[i] >= top) break;
+        if(top - 1 - shape->bottom[i] < land)
+            land = top - 1 - shape->bottom[i];
+    }
+    if(i > shape->max_x) return land;
+
+    y = g->y;
+    while(block_collides(g, g->block_number, g->block_state, g->x, y + 1) == 0)
+        y++;
+    return y;
+}
+
+/* 고스트 블록 위치 계산 */
+void calculate_ghost_position(struct game_state *g) {
+    if(g->block_number < I_BLOCK || g->block_number > O_BLOCK) {
+        g->ghost_y = g->y;
+        return;
+    }
+    g->ghost_y = landing_y(g);
+}
+
+// 고스트 위치만 새로 계산 (그리는 건 렌더러가 한다)
+void ghost_rf(struct game_state *g) {
+    calculate_ghost_position(g);
+}
+
+/* (block, state)를 (bx, by)에 놓았을 때 row행에 걸치는 칸. 보드 안쪽만 */
+row_t piece_row(int block, int state, int bx, int by, int row) {
+    int i = row - by;
+
+    if(block < I_BLOCK || block > O_BLOCK || i < 0 || i > 3) return 0;
+    return ROW_BITS(block_table[block][state].row_mask[i], bx) & FIELD_MASK;
+}
@@ -0,0 +1,151 @@
+#ifndef TETRIS_ENGINE_H
+#define TETRIS_ENGINE_H
+
+#include <stdint.h>
+
+/* 게임 상수 정의 */
+#define LEFT 0
+#define RIGHT 1
+#define DOWN 2
+#define ROTATE 3
+#define HARD_DROP 4     /* game_command() 전용 */
+#define QUIT 5
+
+#define I_BLOCK 0
+#define T_BLOCK 1
+#define S_BLOCK 2
+#define Z_BLOCK 3
+#define L_BLOCK 4
+#define J_BLOCK 5
+#define O_BLOCK 6
+
+#define GAME_START 0
+#define GAME_END 1
+
+/* 레벨: 지운 줄 LEVEL_LINES개마다 하나씩 오르고, MAX_LEVEL이 20G.
+ * 20G에서는 블록이 나오자마자, 그리고 움직일 때마다 바로 바닥까지 내려가 있고
+ * 중력 한 번이 곧 굳히기라서 그 간격이 굳기 전까지 움직일 수 있는 시간이다 */
+#define LEVEL_LINES 10
+#define MAX_LEVEL 20
+
+/* 블록 순서 생성 방식 */
+#define RANDOMIZER_UNIFORM 0    /* 매번 7개 중 하나 */
+#define RANDOMIZER_BAG 1        /* 7개를 섞은 가방을 차례로 꺼냄 */
+
+/* 블록 정의
+ * 블록/회전마다 채워진 4칸의 오프셋, 행 마스크, 바운딩 박스를 담은 상수 테이블.
+ * 칸 좌표만 적으면 나머지는 engine.c의 매크로가 컴파일 타임에 계산한다. */
+struct block_cell {
+    signed char x, y;
+};
+
+struct block_shape {
+    struct block_cell cell[4];      /* 채워진 칸 (열, 행) */
+    unsigned char row_mask[4];      /* 행별 마스크, 비트 j = j번째 칸 */
+    signed char bottom[4];          /* 열별 가장 아래 칸의 행, 빈 열은 -1 */
+    signed char min_x, max_x;       /* 바운딩 박스 */
+    signed char min_y, max_y;
+};
+
+extern const struct block_shape block_table[7][4];
+
+/* 보드 크기 (벽 안쪽). 컴파일할 때 -DBOARD_WIDTH=.. -DBOARD_HEIGHT=..로 바꾼다.
+ * 크기가 상수라서 열/행 루프는 빌드마다 그 크기에 맞게 펼쳐진다.
+ * 기본값은 원래 게임 그대로 가로 8칸(벽 포함 10칸) x 세로 20칸. */
+#ifndef BOARD_WIDTH
+#define BOARD_WIDTH 8
+#endif
+#ifndef BOARD_HEIGHT
+#define BOARD_HEIGHT 20
+#endif
+
+#define BOARD_COLS (BOARD_WIDTH + 2)                /* 양쪽 벽 포함 */
+#define RIGHT_WALL (BOARD_WIDTH + 1)
+#define SPAWN_X ((BOARD_WIDTH - 4) / 2 + 1)         /* 4칸 상자를 가운데에 */
+
+/* 비트보드 정의
+ * 한 행을 워드 하나로 표현한다. 열 c는 비트 (c + BOARD_SHIFT)에 대응하고
+ * 벽(0열, 오른쪽 벽)과 그 바깥은 전부 1로 채워 둔다. 블록의 x가 -3까지 내려갈 수
+ * 있어서 BOARD_SHIFT만큼 밀어 두면 시프트가 항상 양수가 된다.
+ * 오른쪽 벽 너머로 3칸까지 검사하므로 한 행에 BOARD_WIDTH + 5비트가 필요하고,
+ * 그에 맞춰 행 타입이 32비트나 64비트로 정해진다 (가로 59칸까지). */
+#if BOARD_WIDTH < 4 || BOARD_HEIGHT < 4
+#error "board must be at least 4x4"
+#elif BOARD_WIDTH + 5 <= 32
+typedef uint32_t row_t;
+#define ROW_CTZ(row) __builtin_ctz(row)
+#elif BOARD_WIDTH + 5 <= 64
+typedef uint64_t row_t;
+#define ROW_CTZ(row) __builtin_ctzll(row)
+#else
+#error "BOARD_WIDTH is at most 59"
+#endif
+#if BOARD_HEIGHT > 63
+#error "BOARD_HEIGHT is at most 63"
+#endif
+
+#define BOARD_SHIFT 3
+#define BOARD_ROWS (BOARD_HEIGHT + 4)               /* 보드 + 바닥 + 회전용 여유 */
+#define FIELD_MASK ((((row_t)1 << BOARD_WIDTH) - 1) << (1 + BOARD_SHIFT)) /* 1~BOARD_WIDTH열 */
+#define FULL_ROW ((row_t)~(row_t)0)
+#define EMPTY_ROW ((row_t)~FIELD_MASK)
+#define ROW_BITS(mask, col) ((row_t)(mask) << ((col) + BOARD_SHIFT))
+#define CELL_SET(row, col) (((row) >> ((col) + BOARD_SHIFT)) & 1)
+
+/* 게임 하나의 전체 상태. 전역 변수 없이 이 구조체만으로 게임이 진행되므로
+ * 한 프로세스 안에서 여러 게임을 동시에 돌릴 수 있다. */
+struct game_state {
+    row_t tetris_table[BOARD_ROWS]; /* 굳은 블록 + 벽/바닥 */
+    unsigned char height[BOARD_COLS]; /* 열마다 바닥에서 가장 높은 굳은 칸까지 높이, 벽은 BOARD_HEIGHT */
+    int block_number;
+    int next_block_number;
+    int block_state;
+    int x, y;                       /* 움직이는 블록은 보드에 그리지 않고 위치만 둔다 */
+    int ghost_y;
+    long point;
+    int game;
+
+    /* 레벨. leveling이 0이면 예전 규칙 그대로 (속도 고정, 20G 없음) */
+    int leveling;
+    int level;
+    long lines;                     /* 지운 줄 수 */
+    unsigned long pieces;           /* 나온 블록 수. 바뀌면 새 블록 */
+
+    /* 블록 순서. 게임마다 따로 가진 시드 기반 난수라 같은 시드면 같은 순서 */
+    uint64_t rng;
+    int randomizer;
+    unsigned char bag[7];
+    int bag_left;
+};
+
+/* 난수 (splitmix64) */
+uint64_t rng_next(uint64_t *state);
+uint32_t rng_below(uint64_t *state, uint32_t n);
+int next_piece(struct game_state *g);
+
+/* 게임 진행 */
+void game_init(struct game_state *g, uint64_t seed, int randomizer);
+int init_tetris_table(struct game_state *g);
+int block_collides(const struct game_state *g, int block, int state, int bx, int by);
+int collision_test(const struct game_state *g, int command);
+int move_block(struct game_state *g, int command);
+int game_command(struct game_state *g, int command);
+int drop(struct game_state *g);
+int gravity_step(struct game_state *g);
+long gravity_interval_us(const struct game_state *g);
+int place_block(struct game_state *g);
+void lock_block(struct game_state *g);
+int check_one_line(struct game_state *g);
+void update_heights(struct game_state *g);
+int landing_y(const struct game_state *g);
+void spawn_block(struct game_state *g);
+
+/* 화면용 레이어
+ * 보드(tetris_table)에는 굳은 블록만 있고, 굳힐 때만 바뀐다. 움직이는 블록과
+ * 고스트는 (블록, 회전, x, y / ghost_y)만 가지고 있다가 그릴 때 piece_row()로
+ * 행마다 합친다. */
+void calculate_ghost_position(struct game_state *g);
+void ghost_rf(struct game_state *g);
+row_t piece_row(int block, int state, int bx, int by, int row);
+
+#endif
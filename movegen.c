@@ -0,0 +1,162 @@
+#include <stdint.h>
+
+#include "engine.h"
+#include "movegen.h"
+
+/* 위치 공간은 (회전, x, y). x는 -3~BOARD_WIDTH, y는 0~BOARD_HEIGHT-1이라 한 워드의
+ * 비트로 넣을 수 있어서 (회전, x)마다 y 비트셋 하나로 계산한다.
+ * 바닥 비트까지 들어가야 해서 세로 31칸까지는 32비트, 그 위로는 64비트 */
+#if BOARD_HEIGHT <= 31
+typedef uint32_t ybits_t;
+#define Y_CTZ(v) __builtin_ctz(v)
+#else
+typedef uint64_t ybits_t;
+#define Y_CTZ(v) __builtin_ctzll(v)
+#endif
+
+#define MG_MIN_X (-3)
+#define MG_COLS (BOARD_WIDTH + 4)
+#define MG_Y_MASK ((((ybits_t)1) << BOARD_HEIGHT) - 1)     /* y 0~BOARD_HEIGHT-1 */
+
+/* 회전했을 때 모양이 같은 상태 중 가장 작은 회전 번호 */
+static const signed char block_alias[7][4] = {
+    {0, 1, 0, 1},   /* I_BLOCK: 가로/세로 두 가지 */
+    {0, 1, 2, 3},   /* T_BLOCK */
+    {0, 1, 0, 1},   /* S_BLOCK */
+    {0, 1, 0, 1},   /* Z_BLOCK */
+    {0, 1, 2, 3},   /* L_BLOCK */
+    {0, 1, 2, 3},   /* J_BLOCK */
+    {0, 0, 0, 0}    /* O_BLOCK */
+};
+
+/* seed에서 아래로(y 증가 방향) free가 이어지는 데까지 채우기.
+ * free + seed의 자리올림이 연속된 빈칸을 따라 내려가는 것을 이용한다. */
+static ybits_t fill_down(ybits_t seed, ybits_t free) {
+    seed &= free;
+    return (((free + seed) ^ free) & free) | seed;
+}
+
+int enumerate_placements(const struct game_state *g, struct placement *out) {
+    ybits_t col[MG_COLS + 3];              /* 열별 점유 비트 (비트 y = y행) */
+    ybits_t free[4][MG_COLS];
+    ybits_t reach[4][MG_COLS];
+    ybits_t seen[4][MG_COLS];
+    int lo_x[4], hi_x[4];
+    int block = g->block_number;
+    unsigned dirty;
+    int s, xi, i, n = 0;
+
+    if(block < I_BLOCK || block > O_BLOCK) return 0;
+
+    /* 행 비트보드를 열 비트보드로 뒤집기. 벽과 바닥 아래는 전부 막힘 */
+    for(xi = 0; xi < MG_COLS + 3; xi++) {
+        int c = xi + MG_MIN_X;
+        col[xi] = (c < 1 || c > BOARD_WIDTH) ? ~(ybits_t)0 : ~MG_Y_MASK;
+    }
+    for(i = 0; i < BOARD_HEIGHT; i++) {
+        row_t cells = g->tetris_table[i] & FIELD_MASK;
+        while(cells) {
+            int c = ROW_CTZ(cells) - BOARD_SHIFT;
+            cells &= cells - 1;
+            col[c - MG_MIN_X] |= (ybits_t)1 << i;
+        }
+    }
+
+    /* (회전, x)마다 블록이 들어갈 수 있는 y. 칸 단위로 열 전체를 한 번에 처리하고
+     * 벽 안에 들어가는 x 범위만 남긴다 */
+    for(s = 0; s < 4; s++) {
+        const struct block_shape *shape = &block_table[block][s];
+        ybits_t blocked[MG_COLS] = {0};
+
+        for(i = 0; i < 4; i++) {
+            const ybits_t *c = &col[shape->cell[i].x];
+            int cy = shape->cell[i].y;
+            for(xi = 0; xi < MG_COLS; xi++)
+                blocked[xi] |= c[xi] >> cy;
+        }
+
+        lo_x[s] = 1 - shape->min_x - MG_MIN_X;
+        hi_x[s] = BOARD_WIDTH - shape->max_x - MG_MIN_X;
+        for(xi = 0; xi < MG_COLS; xi++) {
+            free[s][xi] = (xi < lo_x[s] || xi > hi_x[s]) ? 0 : ~blocked[xi] & MG_Y_MASK;
+            reach[s][xi] = 0;
+            seen[s][xi] = 0;
+        }
+    }
+
+    if(g->y < 0 || g->y >= BOARD_HEIGHT || g->x < MG_MIN_X || g->x >= MG_MIN_X + MG_COLS) return 0;
+    reach[g->block_state][g->x - MG_MIN_X] = fill_down((ybits_t)1 << g->y, free[g->block_state][g->x - MG_MIN_X]);
+    if(reach[g->block_state][g->x - MG_MIN_X] == 0) return 0;
+
+    /* 회전마다 좌우 이동+내리기를 닫은 뒤 다음 회전으로 넘긴다.
+     * 새로 늘어난 회전만 다시 처리하고, 더 늘지 않으면 끝 */
+    s = g->block_state;
+    dirty = 1u << s;
+    while(dirty) {
+        ybits_t *r = reach[s];
+        ybits_t *f = free[s];
+        ybits_t *next = reach[(s + 1) & 3];
+        ybits_t *next_free = free[(s + 1) & 3];
+        int lo = lo_x[s], hi = hi_x[s];
+        int grew;
+
+        if(!(dirty & (1u << s))) {
+            s = (s + 1) & 3;
+            continue;
+        }
+        dirty &= ~(1u << s);
+
+        /* 왼쪽으로 밀었다가 내려가서 다시 오른쪽으로 가는 경우가 있어서
+         * 오른쪽->왼쪽 훑기에서 늘어난 게 없을 때까지 반복 */
+        do {
+            grew = 0;
+            for(xi = lo + 1; xi <= hi; xi++)
+                r[xi] = fill_down(r[xi] | (r[xi - 1] & f[xi]), f[xi]);
+            for(xi = hi - 1; xi >= lo; xi--) {
+                ybits_t v = fill_down(r[xi] | (r[xi + 1] & f[xi]), f[xi]);
+                if(v != r[xi]) { r[xi] = v; grew = 1; }
+            }
+        } while(grew);
+
+        grew = 0;
+        for(xi = lo; xi <= hi; xi++) {
+            ybits_t v = fill_down(next[xi] | (r[xi] & next_free[xi]), next_free[xi]);
+            if(v != next[xi]) { next[xi] = v; grew = 1; }
+        }
+        if(grew) dirty |= 1u << ((s + 1) & 3);
+
+        s = (s + 1) & 3;
+    }
+
+    /* 한 칸 아래가 막힌 곳이 멈추는 위치. 같은 모양 회전은 좌표를 맞춰서 중복 제거 */
+    for(s = 0; s < 4; s++) {
+        int a = block_alias[block][s];
+        int dx = block_table[block][s].min_x - block_table[block][a].min_x;
+        int dy = block_table[block][s].min_y - block_table[block][a].min_y;
+
+        for(xi = lo_x[s]; xi <= hi_x[s]; xi++) {
+            ybits_t rest = reach[s][xi] & ~(free[s][xi] >> 1);
+            int ax = xi + dx;
+
+            if(a != s && ax >= 0 && ax < MG_COLS) {
+                ybits_t shifted = dy >= 0 ? rest << dy : rest >> -dy;
+                ybits_t dup = seen[a][ax] & shifted;
+                rest &= ~(dy >= 0 ? dup >> dy : dup << -dy);
+                seen[a][ax] |= shifted;
+            } else {
+                seen[s][xi] |= rest;
+            }
+
+            while(rest) {
+                int y = Y_CTZ(rest);
+                rest &= rest - 1;
+                out[n].block_state = (signed char)s;
+                out[n].x = (signed char)(xi + MG_MIN_X);
+                out[n].y = (signed char)y;
+                n++;
+            }
+        }
+    }
+
+    return n;
+}
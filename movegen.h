@@ -0,0 +1,19 @@
+#ifndef TETRIS_MOVEGEN_H
+#define TETRIS_MOVEGEN_H
+
+#include "engine.h"
+
+/* 놓을 수 있는 최종 위치 수의 상한 (회전 4 x 열 x 행) */
+#define MAX_PLACEMENTS (4 * (BOARD_WIDTH + 4) * BOARD_HEIGHT)
+
+struct placement {
+    signed char block_state;
+    signed char x, y;
+};
+
+/* 현재 블록이 지금 위치에서 LEFT/RIGHT/DOWN/ROTATE만으로 도달해 멈출 수 있는
+ * 모든 위치를 out에 채우고 개수를 반환한다. 모양이 같은 회전(O 전부, I/S/Z의
+ * 반대 회전)은 보드에 남는 칸이 같으면 한 번만 나온다. */
+int enumerate_placements(const struct game_state *g, struct placement *out);
+
+#endif
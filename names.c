@@ -0,0 +1,641 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "names.h"
+
+#define MIN_SLOTS 64
+
+/* 이름을 소문자로 접어서 키로. len칸 안에서 끊는다 */
+static void fold_name(const char *name, size_t len, char *key) {
+    size_t i;
+
+    memset(key, 0, NAME_KEY_SIZE);
+    for(i = 0; i < len && i < NAME_KEY_SIZE - 1 && name[i] != '\0'; i++)
+        key[i] = (char)tolower((unsigned char)name[i]);
+}
+
+/* 이름 그대로. fold_name과 같은 곳에서 끊는다 */
+static void copy_name(const char *name, size_t len, char *out) {
+    size_t i;
+
+    memset(out, 0, NAME_KEY_SIZE);
+    for(i = 0; i < len && i < NAME_KEY_SIZE - 1 && name[i] != '\0'; i++)
+        out[i] = name[i];
+}
+
+/* FNV-1a */
+static uint32_t hash_key(const char *key) {
+    uint32_t h = 2166136261u;
+    int i;
+
+    for(i = 0; i < NAME_KEY_SIZE && key[i] != '\0'; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static long slots_offset(void) {
+    return (long)sizeof(struct name_index_header);
+}
+
+static long players_offset(uint32_t slots) {
+    return slots_offset() + (long)slots * (long)sizeof(uint32_t);
+}
+
+static int write_header(FILE *fp, const struct name_index_header *h) {
+    return fseek(fp, 0, SEEK_SET) == 0 && fwrite(h, sizeof(*h), 1, fp) == 1 && fflush(fp) == 0;
+}
+
+/* 메모리에서 새로 만들 때 쓰는 표 */
+struct name_build {
+    uint32_t *slots;
+    uint32_t slot_count;
+    struct player_entry *players;
+    long player_count, player_cap;
+};
+
+static int build_grow_slots(struct name_build *b) {
+    uint32_t count = b->slot_count ? b->slot_count * 2 : MIN_SLOTS;
+    uint32_t *slots = calloc(count, sizeof(uint32_t));
+    long i;
+
+    if(slots == NULL) return 1;
+    for(i = 0; i < b->player_count; i++) {
+        uint32_t s = hash_key(b->players[i].key) & (count - 1);
+        while(slots[s] != 0) s = (s + 1) & (count - 1);
+        slots[s] = (uint32_t)i + 1;
+    }
+    free(b->slots);
+    b->slots = slots;
+    b->slot_count = count;
+    return 0;
+}
+
+/* 이름의 플레이어 번호. 없으면 새로 넣는다. 자리는 접은 키로 찾는다 */
+static long build_player(struct name_build *b, const char *key, const char *name) {
+    uint32_t s;
+
+    /* 슬롯은 절반 넘게 채우지 않는다 */
+    if((b->player_count + 1) * 2 > (long)b->slot_count && build_grow_slots(b) != 0) return -1;
+
+    s = hash_key(key) & (b->slot_count - 1);
+    while(b->slots[s] != 0) {
+        struct player_entry *p = &b->players[b->slots[s] - 1];
+        if(memcmp(p->name, name, NAME_KEY_SIZE) == 0) return b->slots[s] - 1;
+        s = (s + 1) & (b->slot_count - 1);
+    }
+
+    if(b->player_count == b->player_cap) {
+        long cap = b->player_cap ? b->player_cap * 2 : 64;
+        struct player_entry *players = realloc(b->players, cap * sizeof(struct player_entry));
+        if(players == NULL) return -1;
+        b->players = players;
+        b->player_cap = cap;
+    }
+    memset(&b->players[b->player_count], 0, sizeof(struct player_entry));
+    memcpy(b->players[b->player_count].key, key, NAME_KEY_SIZE);
+    memcpy(b->players[b->player_count].name, name, NAME_KEY_SIZE);
+    b->players[b->player_count].first = NO_RECORD;
+    b->players[b->player_count].last = NO_RECORD;
+    b->slots[s] = (uint32_t)b->player_count + 1;
+    return b->player_count++;
+}
+
+/* 기록 하나를 플레이어 합계에 더한다. 중앙값은 따로 구한다 */
+static void add_game(struct player_entry *p, const struct result_record *rec, uint32_t record) {
+    struct result r;
+
+    record_decode(rec, &r);
+    if(p->games == 0 || r.point > p->best) p->best = r.point;
+    p->total += r.point;
+    p->last_played = (((int64_t)r.year * 100 + r.month) * 100 + r.day) * 10000 + r.hour * 100 + r.min;
+    if(p->first == NO_RECORD) p->first = record;
+    p->last = record;
+    p->games++;
+}
+
+/* points[k]가 k번째로 작은 값이 되도록 나눈다 (quickselect, 평균 O(n)).
+ * 끝나면 k 앞은 모두 points[k] 이하, 뒤는 이상 */
+static int64_t select_point(int64_t *points, long n, long k) {
+    long lo = 0, hi = n - 1;
+
+    while(lo < hi) {
+        int64_t pivot = points[lo + (hi - lo) / 2];
+        long i = lo, j = hi;
+
+        while(i <= j) {
+            while(points[i] < pivot) i++;
+            while(points[j] > pivot) j--;
+            if(i <= j) {
+                int64_t t = points[i];
+                points[i++] = points[j];
+                points[j--] = t;
+            }
+        }
+        if(k <= j) hi = j;
+        else if(k >= i) lo = i;
+        else break;
+    }
+    return points[k];
+}
+
+static int64_t median_of(int64_t *points, long n) {
+    int64_t hi, lo;
+    long i;
+
+    if(n == 0) return 0;
+    hi = select_point(points, n, n / 2);
+    if(n & 1) return hi;
+    /* 가운데 아래쪽은 앞쪽 절반의 최댓값 */
+    lo = points[0];
+    for(i = 1; i < n / 2; i++)
+        if(points[i] > lo) lo = points[i];
+    return lo + (hi - lo) / 2;
+}
+
+/* 기록 파일을 처음부터 읽어 두 파일을 제자리에서 새로 쓴다. 넣은 기록 수, 실패하면 -1.
+ * 파일을 줄이지는 않아서 매핑해 읽는 쪽이 끝 너머를 건드릴 일이 없다 */
+static long name_index_rebuild(FILE *fp, FILE *links_fp, uint32_t seq) {
+    struct name_build b;
+    struct name_index_header h;
+    struct record_view v;
+    uint32_t *links = NULL;
+    int64_t *points = NULL;
+    long i, total = 0;
+    int ok = 0;
+
+    memset(&b, 0, sizeof(b));
+    if(build_grow_slots(&b) != 0) return -1;
+
+    if(records_open_view(&v) == 0) total = v.count;
+    links = malloc(sizeof(uint32_t) * (total > 0 ? total : 1));
+    if(links == NULL) goto done;
+
+    for(i = 0; i < total; i++) {
+        char key[NAME_KEY_SIZE], name[NAME_KEY_SIZE];
+        struct player_entry *p;
+        long player;
+
+        /* 체크섬이 틀린 기록은 어느 플레이어에도 붙이지 않는다 */
+        if(!record_valid(&v.records[i])) {
+            links[i] = NO_RECORD;
+            continue;
+        }
+        fold_name(v.records[i].name, sizeof(v.records[i].name), key);
+        copy_name(v.records[i].name, sizeof(v.records[i].name), name);
+        player = build_player(&b, key, name);
+        if(player < 0) goto done;
+
+        p = &b.players[player];
+        links[i] = p->last;
+        add_game(p, &v.records[i], (uint32_t)i);
+    }
+
+    /* 플레이어마다 사슬을 따라 최근 점수를 모아 중앙값. 다 합쳐 기록 수만큼만 본다 */
+    points = malloc(sizeof(int64_t) * (total > 0 ? total : 1));
+    if(points == NULL) goto done;
+    for(i = 0; i < b.player_count; i++) {
+        struct player_entry *p = &b.players[i];
+        uint32_t r = p->last;
+        long n = 0;
+
+        while(n < (long)p->games && n < NAME_MEDIAN_GAMES && r != NO_RECORD) {
+            points[n++] = record_point(&v.records[r]);
+            r = links[r];
+        }
+        p->median = median_of(points, n);
+    }
+
+    fseek(links_fp, 0, SEEK_SET);
+    fwrite(links, sizeof(uint32_t), total, links_fp);
+    ok = fflush(links_fp) == 0;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, NAME_INDEX_MAGIC, 4);
+    h.version = NAME_INDEX_VERSION;
+    h.slots = b.slot_count;
+    h.players = (uint32_t)b.player_count;
+    h.records = (uint32_t)total;
+    h.seq = seq;
+
+    ok = ok && write_header(fp, &h);
+    fwrite(b.slots, sizeof(uint32_t), b.slot_count, fp);
+    fwrite(b.players, sizeof(struct player_entry), b.player_count, fp);
+    ok = ok && fflush(fp) == 0;
+
+done:
+    records_close_view(&v);
+    free(links);
+    free(points);
+    free(b.slots);
+    free(b.players);
+    return ok ? total : -1;
+}
+
+static int read_player(FILE *fp, const struct name_index_header *h, long i, struct player_entry *p) {
+    return fseek(fp, players_offset(h->slots) + i * (long)sizeof(*p), SEEK_SET) == 0 &&
+           fread(p, sizeof(*p), 1, fp) == 1;
+}
+
+static int write_player(FILE *fp, const struct name_index_header *h, long i, const struct player_entry *p) {
+    return fseek(fp, players_offset(h->slots) + i * (long)sizeof(*p), SEEK_SET) == 0 &&
+           fwrite(p, sizeof(*p), 1, fp) == 1;
+}
+
+/* 이어 넣는 동안 사슬을 읽는 곳. 이번에 넣기 전의 링크는 매핑해서 보고,
+ * 이번에 넣은 것은 메모리에 따로 둔다 (파일에 쓰는 중인 부분은 매핑에 없을 수 있음) */
+struct link_chain {
+    struct mapped_file map;
+    const uint32_t *old;
+    long old_count;
+    uint32_t *fresh;
+    long base;              /* fresh[0]의 기록 번호 */
+};
+
+static uint32_t chain_next(const struct link_chain *c, uint32_t r) {
+    if(r >= c->base) return c->fresh[r - c->base];
+    return r < c->old_count ? c->old[r] : NO_RECORD;
+}
+
+/* 새 기록부터 사슬을 따라가며 그 플레이어의 최근 점수를 모아 중앙값을 다시 구한다.
+ * 많아야 NAME_MEDIAN_GAMES판이라 저장 한 번의 비용은 판 수와 상관없다 */
+static void update_median(const struct link_chain *c, const struct record_view *v, struct player_entry *p) {
+    int64_t points[NAME_MEDIAN_GAMES];
+    uint32_t r = p->last;
+    long n = 0;
+
+    while(n < (long)p->games && n < NAME_MEDIAN_GAMES && r != NO_RECORD && r < v->count) {
+        points[n++] = record_point(&v->records[r]);
+        r = chain_next(c, r);
+    }
+    p->median = median_of(points, n);
+}
+
+/* 기록 하나를 색인에 이어 넣는다. 슬롯이 절반을 넘으면 1을 돌려서 다시 만들게 함 */
+static int name_index_add(FILE *fp, FILE *links, struct link_chain *c, struct name_index_header *h,
+                          const struct record_view *v, uint32_t record) {
+    const struct result_record *r = &v->records[record];
+    struct player_entry p;
+    char key[NAME_KEY_SIZE], name[NAME_KEY_SIZE];
+    uint32_t s, slot = 0;
+    long player = -1;
+
+    if(!record_valid(r)) {
+        slot = NO_RECORD;
+        c->fresh[record - c->base] = NO_RECORD;
+        fseek(links, (long)record * (long)sizeof(uint32_t), SEEK_SET);
+        return fwrite(&slot, sizeof(slot), 1, links) == 1 ? 0 : 1;
+    }
+
+    fold_name(r->name, sizeof(r->name), key);
+    copy_name(r->name, sizeof(r->name), name);
+    s = hash_key(key) & (h->slots - 1);
+    for(;;) {
+        if(fseek(fp, slots_offset() + (long)s * (long)sizeof(uint32_t), SEEK_SET) != 0 ||
+           fread(&slot, sizeof(slot), 1, fp) != 1) return 1;
+        if(slot == 0) break;
+        if(!read_player(fp, h, slot - 1, &p)) return 1;
+        if(memcmp(p.name, name, NAME_KEY_SIZE) == 0) {
+            player = slot - 1;
+            break;
+        }
+        s = (s + 1) & (h->slots - 1);
+    }
+
+    if(player < 0) {
+        if((h->players + 1) * 2 > h->slots) return 1;
+        player = h->players++;
+        memset(&p, 0, sizeof(p));
+        memcpy(p.key, key, NAME_KEY_SIZE);
+        memcpy(p.name, name, NAME_KEY_SIZE);
+        p.first = NO_RECORD;
+        p.last = NO_RECORD;
+        slot = (uint32_t)player + 1;
+        fseek(fp, slots_offset() + (long)s * (long)sizeof(uint32_t), SEEK_SET);
+        fwrite(&slot, sizeof(slot), 1, fp);
+    }
+
+    fseek(links, (long)record * (long)sizeof(uint32_t), SEEK_SET);
+    if(fwrite(&p.last, sizeof(uint32_t), 1, links) != 1 || fflush(links) != 0) return 1;
+    c->fresh[record - c->base] = p.last;
+    add_game(&p, r, record);
+    update_median(c, v, &p);
+    return write_player(fp, h, player, &p) ? 0 : 1;
+}
+
+static int header_ok(const struct name_index_header *h) {
+    return memcmp(h->magic, NAME_INDEX_MAGIC, 4) == 0 && h->version == NAME_INDEX_VERSION &&
+           h->slots >= MIN_SLOTS && (h->slots & (h->slots - 1)) == 0;
+}
+
+/* 잠그지 않고 헤더만 본다 */
+static int read_header(struct name_index_header *h) {
+    FILE *fp = fopen(NAME_INDEX_FILE, "rb");
+    int ok;
+
+    if(fp == NULL) return 1;
+    ok = fread(h, sizeof(*h), 1, fp) == 1 && header_ok(h);
+    fclose(fp);
+    return ok ? 0 : 1;
+}
+
+/* 기록 base부터 count 앞까지 이어 넣을 준비. 링크 파일은 잠금을 쥔 뒤에 매핑한다 */
+static int open_chain(struct link_chain *c, long base, long count) {
+    memset(c, 0, sizeof(*c));
+    if(map_file(NAME_LINK_FILE, &c->map) != 0) return 1;
+    c->old = (const uint32_t *)c->map.data;
+    c->old_count = (long)(c->map.size / sizeof(uint32_t));
+    if(c->old_count > base) c->old_count = base;
+    c->base = base;
+    c->fresh = malloc(sizeof(uint32_t) * (count - base + 1));
+    if(c->fresh == NULL) {
+        unmap_file(&c->map);
+        return 1;
+    }
+    return 0;
+}
+
+static void close_chain(struct link_chain *c) {
+    unmap_file(&c->map);
+    free(c->fresh);
+}
+
+/* 잠금은 이름 파일 하나에만 잡고, 링크 파일도 그 잠금 아래에서만 고친다 */
+int name_index_update(void) {
+    struct name_index_header h;
+    struct link_chain chain;
+    struct record_view v;
+    FILE *fp, *links;
+    long link_size, i, done = -1;
+    uint32_t seq;
+    int valid;
+
+    /* 이미 맞으면 잠그지 않고 끝 */
+    if(read_header(&h) == 0 && !(h.seq & 1) && h.records == records_count()) return 0;
+
+    fp = open_shared(NAME_INDEX_FILE);
+    links = open_shared(NAME_LINK_FILE);
+    if(fp == NULL || links == NULL || lock_file(fp) != 0) {
+        if(fp != NULL) fclose(fp);
+        if(links != NULL) fclose(links);
+        return 1;
+    }
+
+    /* 잠금을 기다리는 동안 다른 프로세스가 맞춰 놨을 수 있으니 다시 읽는다 */
+    if(records_open_view(&v) != 0) v.count = 0;
+    valid = fread(&h, sizeof(h), 1, fp) == 1 && header_ok(&h);
+    if(valid && !(h.seq & 1) && h.records == v.count) {
+        records_close_view(&v);
+        unlock_file(fp);
+        fclose(links);
+        fclose(fp);
+        return 0;
+    }
+
+    /* seq가 홀수인 채 남아 있으면 고치던 프로세스가 죽은 것 */
+    seq = ((valid ? h.seq : 0) + 1) | 1;
+    fseek(links, 0, SEEK_END);
+    link_size = ftell(links);
+    if(valid && !(h.seq & 1) && h.records <= v.count &&
+       link_size >= (long)h.records * (long)sizeof(uint32_t) &&
+       open_chain(&chain, h.records, v.count) == 0) {
+        h.seq = seq;
+        write_header(fp, &h);
+        fflush(fp);
+        for(i = h.records; i < v.count; i++) {
+            if(name_index_add(fp, links, &chain, &h, &v, (uint32_t)i) != 0) break;
+            h.records = (uint32_t)i + 1;
+        }
+        if(i == v.count) done = v.count;
+        close_chain(&chain);
+    }
+    records_close_view(&v);
+
+    /* 슬롯이 절반을 넘었거나 앞뒤가 맞지 않으면 새로 쓴다 */
+    if(done < 0) {
+        done = name_index_rebuild(fp, links, seq);
+        if(done >= 0 && (fseek(fp, 0, SEEK_SET) != 0 || fread(&h, sizeof(h), 1, fp) != 1)) done = -1;
+    }
+
+    /* 링크와 플레이어 표가 먼저 디스크에 있어야 한다. seq는 마지막에 짝수로 */
+    fflush(links);
+    if(done >= 0) {
+        h.seq = seq + 1;
+        write_header(fp, &h);
+    }
+    unlock_file(fp);
+    fclose(links);
+    fclose(fp);
+
+    return done >= 0 ? 0 : 1;
+}
+
+int name_index_open(struct name_index *ni) {
+    const struct name_index_header *h;
+
+    memset(ni, 0, sizeof(*ni));
+    if(map_file(NAME_INDEX_FILE, &ni->index) != 0) return 1;
+    if(map_file(NAME_LINK_FILE, &ni->links) != 0) {
+        name_index_close(ni);
+        return 1;
+    }
+    if(ni->index.size < sizeof(*h)) {
+        name_index_close(ni);
+        return 1;
+    }
+
+    /* 헤더는 seq를 읽은 뒤 복사해 두고 그 값만 쓴다. 도중에 바뀌었으면
+     * 읽은 쪽이 seq_retry로 알아챈다 */
+    h = (const struct name_index_header *)ni->index.data;
+    ni->seq = &((const volatile struct name_index_header *)h)->seq;
+    ni->start = seq_begin(ni->seq);
+    memcpy(&ni->header, h, sizeof(*h));
+    if(!header_ok(&ni->header) ||
+       ni->index.size < (size_t)players_offset(ni->header.slots) + (size_t)ni->header.players * sizeof(struct player_entry)) {
+        name_index_close(ni);
+        return 1;
+    }
+
+    ni->slots = (const uint32_t *)(ni->index.data + slots_offset());
+    ni->players = (const struct player_entry *)(ni->index.data + players_offset(ni->header.slots));
+    ni->link = (const uint32_t *)ni->links.data;
+    ni->link_count = (long)(ni->links.size / sizeof(uint32_t));
+    return 0;
+}
+
+void name_index_close(struct name_index *ni) {
+    unmap_file(&ni->index);
+    unmap_file(&ni->links);
+    memset(ni, 0, sizeof(*ni));
+}
+
+/* 접은 키가 같은 플레이어를 자리부터 빈 칸까지 훑는다. exact면 이름도 똑같아야 한다 */
+static long probe(const struct name_index *ni, const char *name, int exact, long *players, long max) {
+    char key[NAME_KEY_SIZE], full[NAME_KEY_SIZE];
+    uint32_t s, n;
+    long found = 0;
+
+    fold_name(name, NAME_KEY_SIZE, key);
+    copy_name(name, NAME_KEY_SIZE, full);
+    s = hash_key(key) & (ni->header.slots - 1);
+    /* 슬롯이 절반 넘게 차지 않으니 빈 칸이 금방 나온다 */
+    for(n = 0; n < ni->header.slots && ni->slots[s] != 0 && found < max; n++) {
+        uint32_t player = ni->slots[s] - 1;
+        if(player < ni->header.players &&
+           memcmp(ni->players[player].key, key, NAME_KEY_SIZE) == 0 &&
+           (!exact || memcmp(ni->players[player].name, full, NAME_KEY_SIZE) == 0))
+            players[found++] = player;
+        s = (s + 1) & (ni->header.slots - 1);
+    }
+    return found;
+}
+
+long name_find(const struct name_index *ni, const char *name) {
+    long player;
+
+    return probe(ni, name, 1, &player, 1) == 1 ? player : -1;
+}
+
+long name_matches(const struct name_index *ni, const char *name, long *players, long max) {
+    return probe(ni, name, 0, players, max);
+}
+
+long name_prefix(const struct name_index *ni, const char *prefix, long *players, long max) {
+    char key[NAME_KEY_SIZE];
+    size_t len;
+    long i, found = 0;
+
+    fold_name(prefix, NAME_KEY_SIZE, key);
+    len = strlen(key);
+    for(i = 0; i < (long)ni->header.players && found < max; i++)
+        if(memcmp(ni->players[i].key, key, len) == 0)
+            players[found++] = i;
+    return found;
+}
+
+long name_records(const struct name_index *ni, long player, long *records, long max) {
+    const struct player_entry *p = &ni->players[player];
+    uint32_t r = p->last;
+    long n = 0, i;
+
+    if(max > (long)p->games) max = p->games;
+    /* links는 뒤로 가는 사슬이라 모은 뒤 뒤집는다 */
+    while(n < max && r != NO_RECORD && r < ni->link_count) {
+        records[n++] = r;
+        r = ni->link[r];
+    }
+    for(i = 0; i < n / 2; i++) {
+        long t = records[i];
+        records[i] = records[n - 1 - i];
+        records[n - 1 - i] = t;
+    }
+    return n;
+}
+
+long name_search(const char *query, long **out) {
+    char name[NAME_KEY_SIZE];
+    size_t len;
+    int prefix, tries;
+
+    *out = NULL;
+    len = strlen(query);
+    if(len >= NAME_KEY_SIZE) len = NAME_KEY_SIZE - 1;
+    memcpy(name, query, len);
+    name[len] = '\0';
+    prefix = len > 0 && name[len - 1] == '*';
+    if(prefix) name[len - 1] = '\0';
+
+    name_index_update();
+
+    for(tries = 0; tries < SEQ_RETRIES; tries++) {
+        struct name_index ni;
+        long *players, *records;
+        long player_count = 0, total = 0, count = 0, i;
+
+        if(name_index_open(&ni) != 0) return -1;
+
+        players = malloc(sizeof(long) * (ni.header.players + 1));
+        if(players == NULL) {
+            name_index_close(&ni);
+            return -1;
+        }
+        if(prefix) {
+            player_count = name_prefix(&ni, name, players, ni.header.players);
+        } else {
+            player_count = name_matches(&ni, name, players, ni.header.players);
+        }
+
+        for(i = 0; i < player_count; i++)
+            total += ni.players[players[i]].games;
+        records = malloc(sizeof(long) * (total + 1));
+        for(i = 0; i < player_count && records != NULL; i++)
+            count += name_records(&ni, players[i], records + count, total - count);
+        free(players);
+
+        if(records != NULL && !seq_retry(ni.seq, ni.start)) {
+            name_index_close(&ni);
+            *out = records;
+            return count;
+        }
+        free(records);
+        name_index_close(&ni);
+        if(records == NULL) return -1;
+        seq_pause();
+    }
+    return -1;
+}
+
+int name_player(const char *name, struct player_entry *out) {
+    int tries;
+
+    name_index_update();
+    for(tries = 0; tries < SEQ_RETRIES; tries++) {
+        struct name_index ni;
+        long player, matches[2];
+
+        if(name_index_open(&ni) != 0) return 1;
+        player = name_find(&ni, name);
+        if(player < 0 && name_matches(&ni, name, matches, 2) == 1) player = matches[0];
+        if(player >= 0) memcpy(out, &ni.players[player], sizeof(*out));
+        if(!seq_retry(ni.seq, ni.start)) {
+            name_index_close(&ni);
+            return player >= 0 ? 0 : 1;
+        }
+        name_index_close(&ni);
+        seq_pause();
+    }
+    return 1;
+}
+
+long name_players(struct player_entry **out) {
+    int tries;
+
+    *out = NULL;
+    name_index_update();
+    for(tries = 0; tries < SEQ_RETRIES; tries++) {
+        struct name_index ni;
+        struct player_entry *players;
+        long count;
+
+        if(name_index_open(&ni) != 0) return -1;
+        count = ni.header.players;
+        players = malloc(sizeof(struct player_entry) * (count + 1));
+        if(players == NULL) {
+            name_index_close(&ni);
+            return -1;
+        }
+        memcpy(players, ni.players, sizeof(struct player_entry) * count);
+        if(!seq_retry(ni.seq, ni.start)) {
+            name_index_close(&ni);
+            *out = players;
+            return count;
+        }
+        free(players);
+        name_index_close(&ni);
+        seq_pause();
+    }
+    return -1;
+}
@@ -0,0 +1,94 @@
+#ifndef TETRIS_NAMES_H
+#define TETRIS_NAMES_H
+
+#include <stdint.h>
+
+#include "records.h"
+
+#define NAME_INDEX_FILE "tetris_result.names"
+#define NAME_LINK_FILE "tetris_result.links"
+
+/* 플레이어 이름 색인
+ *   tetris_result.names: 헤더, 해시 슬롯 slots개(플레이어 번호 + 1, 0은 빈 칸),
+ *                        플레이어 표(저장된 순서대로 뒤에 붙는다)
+ *   tetris_result.links: 기록마다 uint32 하나. 같은 플레이어의 바로 앞 기록 번호
+ * 플레이어는 저장된 이름 그대로 구분한다 ("Bob"과 "bob"은 다른 플레이어).
+ * 해시는 대소문자를 접은(소문자) 이름으로 잡아서, 대소문자만 다른 플레이어들은
+ * 같은 자리에서 시작하는 칸들에 모이고 검색은 그 칸들만 보면 된다.
+ * 그 플레이어의 기록은 last에서 links를 따라 거슬러 올라간다.
+ * 헤더의 records는 색인에 반영된 기록 수라서 기록 파일보다 뒤처져 있으면
+ * 그 뒤만 이어서 넣는다. 고치는 동안은 헤더의 seq가 홀수다 (records.h 참고). */
+#define NAME_INDEX_MAGIC "TNAM"
+#define NAME_INDEX_VERSION 3
+#define NAME_KEY_SIZE 32
+#define NO_RECORD 0xFFFFFFFFu
+#define NAME_MEDIAN_GAMES 1024      /* 중앙값은 최근 이만큼의 판으로만 구한다 */
+
+struct name_index_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t slots;         /* 2의 거듭제곱 */
+    uint32_t players;
+    uint32_t records;
+    uint32_t seq;           /* 고치는 중이면 홀수 */
+};
+
+/* 플레이어 하나. 합계는 저장할 때마다 그 플레이어 것만 고쳐서, 통계 화면은
+ * 기록 파일을 다시 읽지 않고 플레이어 표만 훑으면 된다.
+ * 중앙값은 저장마다 사슬을 따라 다시 구하는데, 많이 한 플레이어도 저장 비용이
+ * 늘지 않게 최근 NAME_MEDIAN_GAMES판까지만 본다 */
+struct player_entry {
+    char key[NAME_KEY_SIZE];    /* 접은 이름 (해시와 검색용), 남는 칸은 0 */
+    char name[NAME_KEY_SIZE];   /* 플레이어 이름 그대로, 남는 칸은 0 */
+    uint32_t first;             /* 첫 기록 번호 */
+    uint32_t last;              /* 마지막 기록 번호 */
+    uint32_t games;
+    uint32_t reserved;
+    int64_t best;
+    int64_t total;              /* 점수 합. 평균은 total / games */
+    int64_t median;             /* 최근 판들의 중앙값. 짝수 판이면 가운데 둘의 평균(버림) */
+    int64_t last_played;        /* 마지막 기록 날짜 YYYYMMDDHHMM */
+};
+
+/* 읽기용으로 매핑한 색인. header는 열 때 복사한 것 */
+struct name_index {
+    struct mapped_file index, links;
+    struct name_index_header header;
+    const volatile uint32_t *seq;
+    uint32_t start;
+    const uint32_t *slots;
+    const struct player_entry *players;
+    const uint32_t *link;
+    long link_count;
+};
+
+/* 색인을 기록 파일에 맞춘다. 없거나 깨졌으면 기록 파일에서 다시 만든다 */
+int name_index_update(void);
+
+int name_index_open(struct name_index *ni);
+void name_index_close(struct name_index *ni);
+
+/* 이름이 똑같은 플레이어 번호, 없으면 -1 */
+long name_find(const struct name_index *ni, const char *name);
+
+/* 대소문자만 다르고 이름이 같은 플레이어를 최대 max개. 찾은 개수를 돌려준다 */
+long name_matches(const struct name_index *ni, const char *name, long *players, long max);
+
+/* 접은 이름이 prefix로 시작하는 플레이어를 최대 max개. 찾은 개수를 돌려준다 */
+long name_prefix(const struct name_index *ni, const char *prefix, long *players, long max);
+
+/* 플레이어의 기록 번호를 저장된 순서대로 최대 max개 */
+long name_records(const struct name_index *ni, long player, long *records, long max);
+
+/* 그 이름의 플레이어 항목을 복사. 똑같은 이름이 없으면 대소문자만 다른 플레이어가
+ * 하나뿐일 때 그것을. 찾으면 0 */
+int name_player(const char *name, struct player_entry *out);
+
+/* 플레이어 표 전체를 *out에 malloc해서 복사. O(플레이어 수). 개수, 실패하면 -1 */
+long name_players(struct player_entry **out);
+
+/* 이름 검색 (대소문자 무시). 끝에 *를 붙이면 앞부분 검색. 찾은 기록 번호를 플레이어별로 저장된
+ * 순서대로 *out에 malloc해서 돌려준다. 개수, 색인을 못 읽으면 -1 */
+long name_search(const char *query, long **out);
+
+#endif
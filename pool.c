@@ -0,0 +1,138 @@
+#include <stdlib.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+#include "pool.h"
+
+/* 작업 훔치기 스레드 풀
+ * 각 워커는 자기 몫의 작업 번호 구간 [next, end)를 가진다. 자기 구간은 앞에서
+ * 하나씩 꺼내고, 비면 다른 워커 구간의 뒤쪽 절반을 훔쳐 온다. 작업 하나가
+ * 게임 한 판, 리플레이 하나 정도로 굵어서 구간마다 뮤텍스 하나면 충분하다. */
+struct worker {
+    pthread_mutex_t lock;
+    long next, end;
+
+    int id;
+    struct pool *pool;
+    pthread_t thread;
+    int started;
+};
+
+struct pool {
+    struct worker *workers;
+    int count;
+    pool_job_fn fn;
+    void *ctx;
+};
+
+int cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+/* 자기 구간에서 하나 꺼내기 */
+static int pop_own(struct worker *w, long *job) {
+    int ok = 0;
+    pthread_mutex_lock(&w->lock);
+    if(w->next < w->end) {
+        *job = w->next++;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return ok;
+}
+
+/* 다른 워커 구간의 뒤쪽 절반을 훔쳐서 자기 구간으로 */
+static int steal(struct worker *w) {
+    struct pool *pool = w->pool;
+    int i;
+
+    for(i = 1; i < pool->count; i++) {
+        struct worker *victim = &pool->workers[(w->id + i) % pool->count];
+        long lo = 0, hi = 0;
+
+        pthread_mutex_lock(&victim->lock);
+        if(victim->next < victim->end) {
+            long half = (victim->end - victim->next + 1) / 2;
+            hi = victim->end;
+            lo = hi - half;
+            victim->end = lo;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if(lo < hi) {
+            pthread_mutex_lock(&w->lock);
+            w->next = lo;
+            w->end = hi;
+            pthread_mutex_unlock(&w->lock);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void *worker_main(void *arg) {
+    struct worker *w = arg;
+    long job;
+
+    for(;;) {
+        if(pop_own(w, &job)) {
+            w->pool->fn(w->pool->ctx, w->id, job);
+        } else if(!steal(w)) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+int pool_run(long jobs, int threads, pool_job_fn fn, void *ctx) {
+    struct pool pool;
+    int i;
+
+    if(jobs <= 0) return 0;
+    if(threads <= 0) threads = cpu_count();
+    if(threads > jobs) threads = (int)jobs;
+
+    pool.count = threads;
+    pool.fn = fn;
+    pool.ctx = ctx;
+    pool.workers = calloc(threads, sizeof(struct worker));
+    if(pool.workers == NULL) return 0;
+
+    /* 처음에는 작업을 고르게 나눠 주고, 불균형은 훔치기로 맞춘다 */
+    for(i = 0; i < threads; i++) {
+        struct worker *w = &pool.workers[i];
+        pthread_mutex_init(&w->lock, NULL);
+        w->next = jobs * i / threads;
+        w->end = jobs * (i + 1) / threads;
+        w->id = i;
+        w->pool = &pool;
+    }
+
+    /* 0번 워커는 호출한 스레드가 맡는다. 스레드를 못 만들어도 그 몫은
+     * 다른 워커가 훔쳐 가므로 그대로 진행 */
+    for(i = 1; i < threads; i++)
+        pool.workers[i].started = pthread_create(&pool.workers[i].thread, NULL,
+                                                 worker_main, &pool.workers[i]) == 0;
+    worker_main(&pool.workers[0]);
+    for(i = 1; i < threads; i++)
+        if(pool.workers[i].started)
+            pthread_join(pool.workers[i].thread, NULL);
+
+    for(i = 0; i < threads; i++)
+        pthread_mutex_destroy(&pool.workers[i].lock);
+    free(pool.workers);
+
+    return threads;
+}
@@ -0,0 +1,14 @@
+#ifndef TETRIS_POOL_H
+#define TETRIS_POOL_H
+
+/* 작업 하나를 처리하는 함수. worker는 0 ~ threads-1, job은 0 ~ jobs-1 */
+typedef void (*pool_job_fn)(void *ctx, int worker, long job);
+
+/* jobs개의 작업을 threads개 스레드(0 이하면 코어 수)에 나눠 돌리고 다 끝날 때까지
+ * 기다린다. 실제로 쓴 스레드 수를 반환하고, 실패하면 0 */
+int pool_run(long jobs, int threads, pool_job_fn fn, void *ctx);
+
+/* 사용 가능한 CPU 코어 수 */
+int cpu_count(void);
+
+#endif
@@ -0,0 +1,124 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
+#include "profile.h"
+
+static const char *phase_names[PHASE_COUNT] = {
+    "wait", "input", "gravity", "ghost", "render", "frame"
+};
+
+long long profile_now_us(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if(freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (long long)(now.QuadPart / freq.QuadPart * 1000000 +
+                       now.QuadPart % freq.QuadPart * 1000000 / freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+#endif
+}
+
+/* 16 미만은 그대로, 그 위로는 최상위 비트 자리마다 다음 4비트로 16칸 */
+static int bucket_of(uint64_t v) {
+    int e = 0;
+    uint64_t t;
+
+    if(v < (1u << PROFILE_SUB_BITS)) return (int)v;
+    /* 최상위 비트가 39를 넘으면 마지막 칸으로 (2^40 이상은 모두 같은 칸) */
+    if(v >> 40) v = ((uint64_t)1 << 40) - 1;
+    for(t = v; t > 1; t >>= 1) e++;
+    return ((e - PROFILE_SUB_BITS + 1) << PROFILE_SUB_BITS) +
+           (int)((v >> (e - PROFILE_SUB_BITS)) & ((1u << PROFILE_SUB_BITS) - 1));
+}
+
+/* 칸에 들어가는 가장 큰 값 */
+static uint64_t bucket_top(int i) {
+    int group = i >> PROFILE_SUB_BITS;
+    uint64_t sub = i & ((1 << PROFILE_SUB_BITS) - 1);
+    int shift;
+
+    if(group == 0) return (uint64_t)i;
+    shift = group - 1;
+    return ((((uint64_t)1 << PROFILE_SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+static void hist_add(struct histogram *h, long long us) {
+    uint64_t v = us > 0 ? (uint64_t)us : 0;
+    h->bucket[bucket_of(v)]++;
+    h->count++;
+    if(v > h->max) h->max = v;
+}
+
+/* 하위 q 비율에 드는 값의 상한 (칸 단위라 살짝 크게 나온다) */
+static uint64_t hist_percentile(const struct histogram *h, double q) {
+    uint64_t rank = (uint64_t)(q * h->count + 0.999999), seen = 0;
+    int i;
+
+    if(h->count == 0) return 0;
+    if(rank == 0) rank = 1;
+    for(i = 0; i < PROFILE_BUCKETS; i++) {
+        seen += h->bucket[i];
+        if(seen >= rank) {
+            uint64_t top = bucket_top(i);
+            return top < h->max ? top : h->max;
+        }
+    }
+    return h->max;
+}
+
+void profile_start(struct profile *p, int enabled, long long budget_us) {
+    memset(p, 0, sizeof(*p));
+    p->enabled = enabled;
+    p->budget = budget_us;
+    if(enabled) p->mark = p->frame_start = profile_now_us();
+}
+
+void profile_mark(struct profile *p, enum profile_phase phase) {
+    long long now;
+
+    if(!p->enabled) return;
+    now = profile_now_us();
+    hist_add(&p->phase[phase], now - p->mark);
+    p->mark = now;
+    // 기다림이 끝난 시점부터가 프레임 일
+    if(phase == PHASE_WAIT) p->frame_start = now;
+}
+
+void profile_end_frame(struct profile *p) {
+    long long frame;
+
+    if(!p->enabled) return;
+    frame = p->mark - p->frame_start;
+    hist_add(&p->phase[PHASE_FRAME], frame);
+    if(frame > p->budget) p->missed++;
+}
+
+void profile_report(const struct profile *p, FILE *out) {
+    int i;
+
+    if(!p->enabled) return;
+    fprintf(out, "%-8s %8s %8s %8s %8s %8s  (us)\n",
+            "phase", "count", "p50", "p95", "p99", "max");
+    for(i = 0; i < PHASE_COUNT; i++) {
+        const struct histogram *h = &p->phase[i];
+        if(h->count == 0) continue;
+        fprintf(out, "%-8s %8llu %8llu %8llu %8llu %8llu\n", phase_names[i],
+                (unsigned long long)h->count,
+                (unsigned long long)hist_percentile(h, 0.50),
+                (unsigned long long)hist_percentile(h, 0.95),
+                (unsigned long long)hist_percentile(h, 0.99),
+                (unsigned long long)h->max);
+    }
+    fprintf(out, "missed frames: %ld of %llu (budget %lld us)\n", p->missed,
+            (unsigned long long)p->phase[PHASE_FRAME].count, p->budget);
+}
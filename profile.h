@@ -0,0 +1,56 @@
+#ifndef TETRIS_PROFILE_H
+#define TETRIS_PROFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* 게임 루프 프레임 시간 측정 (--profile 또는 환경 변수 TETRIS_PROFILE)
+ * 한 프레임을 단계별로 나눠 단조 시계로 재고, 단계마다 히스토그램에 쌓는다.
+ * struct profile 하나는 스레드 하나 전용 (시뮬레이션, 렌더 따로).
+ * 히스토그램은 마이크로초 단위이고 2배 구간마다 16칸이라 오차는 6% 안쪽.
+ * 기록은 칸 하나 더하기라서 켜 둬도 프레임에 거의 영향이 없다 */
+enum profile_phase {
+    PHASE_WAIT,         /* 입력, 중력 마감, 새 스냅샷을 기다린 시간 */
+    PHASE_INPUT,        /* 쌓인 키 처리 */
+    PHASE_GRAVITY,      /* 중력으로 한 칸 내리기 (굳히기, 줄 정리 포함) */
+    PHASE_GHOST,        /* ghost_rf */
+    PHASE_RENDER,       /* print_tetris_sc */
+    PHASE_FRAME,        /* 기다린 시간을 뺀 프레임 전체 */
+    PHASE_COUNT
+};
+
+#define PROFILE_SUB_BITS 4
+#define PROFILE_BUCKETS ((40 - PROFILE_SUB_BITS + 1) << PROFILE_SUB_BITS)
+#define FRAME_BUDGET_US 16667   /* 60Hz 한 프레임 */
+
+struct histogram {
+    uint32_t bucket[PROFILE_BUCKETS];
+    uint64_t count;
+    uint64_t max;
+};
+
+struct profile {
+    int enabled;
+    long long mark;             /* 직전 단계가 끝난 시각 (us) */
+    long long frame_start;      /* 기다림이 끝나고 일을 시작한 시각 */
+    long long budget;           /* 프레임 하나에 쓸 수 있는 시간 (us), 넘기면 놓친 프레임 */
+    long missed;
+    struct histogram phase[PHASE_COUNT];
+};
+
+/* 단조 시계 (us). 게임 루프의 중력 마감도 이 시계로 잰다 */
+long long profile_now_us(void);
+
+/* 통계를 비우고 enabled면 잰다. 지금 시각부터 첫 단계가 시작된다 */
+void profile_start(struct profile *p, int enabled, long long budget_us);
+
+/* 직전 mark부터 지금까지를 phase에 더한다 */
+void profile_mark(struct profile *p, enum profile_phase phase);
+
+/* 프레임 하나 끝. 기다림 뒤부터 지금까지를 프레임 시간으로 센다 */
+void profile_end_frame(struct profile *p);
+
+/* 단계별 p50/p95/p99/max와 놓친 프레임 수를 표로 출력. 한 번도 안 잰 단계는 뺀다 */
+void profile_report(const struct profile *p, FILE *out);
+
+#endif
@@ -0,0 +1,800 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <fcntl.h>
+    #include <io.h>
+    #include <sys/stat.h>
+    #define READ_BARRIER() MemoryBarrier()
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define READ_BARRIER() __sync_synchronize()
+#endif
+
+#include "names.h"
+#include "records.h"
+
+/* 이만큼 넘게 밀려 있으면 하나씩 끼우는 것보다 새로 만드는 게 빠르다 */
+#define SCORE_INDEX_BATCH 64
+
+int map_file(const char *path, struct mapped_file *m) {
+    m->data = NULL;
+    m->size = 0;
+
+#ifdef _WIN32
+    HANDLE file, mapping;
+    LARGE_INTEGER size;
+    void *view;
+
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                       OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) return 1;
+    if(!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return 1;
+    }
+    if(size.QuadPart == 0) {
+        CloseHandle(file);
+        return 0;
+    }
+
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if(mapping == NULL) return 1;
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    /* 뷰가 매핑을 붙잡고 있으므로 핸들은 바로 닫아도 된다 */
+    CloseHandle(mapping);
+    if(view == NULL) return 1;
+
+    m->data = view;
+    m->size = (size_t)size.QuadPart;
+#else
+    struct stat st;
+    void *view;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if(fd < 0) return 1;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        return 1;
+    }
+    if(st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(view == MAP_FAILED) return 1;
+
+    m->data = view;
+    m->size = (size_t)st.st_size;
+#endif
+
+    return 0;
+}
+
+void unmap_file(struct mapped_file *m) {
+    if(m->data != NULL) {
+#ifdef _WIN32
+        UnmapViewOfFile((void *)m->data);
+#else
+        munmap((void *)m->data, m->size);
+#endif
+    }
+    m->data = NULL;
+    m->size = 0;
+}
+
+FILE *open_shared(const char *path) {
+#ifdef _WIN32
+    int fd = _open(path, _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+    FILE *fp;
+    if(fd < 0) return NULL;
+    fp = _fdopen(fd, "r+b");
+    if(fp == NULL) _close(fd);
+#else
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    FILE *fp;
+    if(fd < 0) return NULL;
+    fp = fdopen(fd, "r+b");
+    if(fp == NULL) close(fd);
+#endif
+    return fp;
+}
+
+#ifdef _WIN32
+/* Windows 잠금은 강제라서 내용이 아니라 파일 끝 너머의 한 바이트를 잠근다 */
+static int lock_handle(HANDLE h, int lock) {
+    OVERLAPPED ov;
+    memset(&ov, 0, sizeof(ov));
+    ov.OffsetHigh = 0x7FFFFFFF;
+    if(lock)
+        return LockFileEx(h, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &ov) ? 0 : 1;
+    UnlockFileEx(h, 0, 1, 0, &ov);
+    return 0;
+}
+#endif
+
+int lock_file(FILE *fp) {
+#ifdef _WIN32
+    return lock_handle((HANDLE)_get_osfhandle(_fileno(fp)), 1);
+#else
+    struct flock fl;
+
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = F_WRLCK;
+    fl.l_whence = SEEK_SET;
+    while(fcntl(fileno(fp), F_SETLKW, &fl) != 0)
+        if(errno != EINTR) return 1;
+    return 0;
+#endif
+}
+
+void unlock_file(FILE *fp) {
+    fflush(fp);
+#ifdef _WIN32
+    lock_handle((HANDLE)_get_osfhandle(_fileno(fp)), 0);
+#else
+    struct flock fl;
+
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = F_UNLCK;
+    fl.l_whence = SEEK_SET;
+    fcntl(fileno(fp), F_SETLK, &fl);
+#endif
+}
+
+uint32_t seq_begin(const volatile uint32_t *seq) {
+    uint32_t v = *seq;
+    READ_BARRIER();
+    return v;
+}
+
+int seq_retry(const volatile uint32_t *seq, uint32_t start) {
+    READ_BARRIER();
+    return (start & 1) || *seq != start;
+}
+
+void seq_pause(void) {
+#ifdef _WIN32
+    Sleep(1);
+#else
+    struct timespec ts = {0, 1000000};
+    nanosleep(&ts, NULL);
+#endif
+}
+
+/* CRC32 (IEEE, 반사형). 표는 처음 쓸 때 만든다 */
+static uint32_t crc_table[256];
+static int crc_ready = 0;
+
+static uint32_t crc32(const unsigned char *p, size_t len) {
+    uint32_t c = 0xFFFFFFFFu;
+    size_t i;
+
+    if(!crc_ready) {
+        uint32_t n, k;
+        for(n = 0; n < 256; n++) {
+            c = n;
+            for(k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crc_table[n] = c;
+        }
+        crc_ready = 1;
+        c = 0xFFFFFFFFu;
+    }
+    for(i = 0; i < len; i++)
+        c = crc_table[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+static void put_le(unsigned char *p, uint64_t v, int bytes) {
+    int i;
+    for(i = 0; i < bytes; i++)
+        p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint64_t get_le(const unsigned char *p, int bytes) {
+    uint64_t v = 0;
+    int i;
+    for(i = 0; i < bytes; i++)
+        v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static void make_file_header(unsigned char *h) {
+    memset(h, 0, RESULT_HEADER_SIZE);
+    memcpy(h, RESULT_MAGIC, 4);
+    put_le(h + 4, RESULT_VERSION, 4);
+    put_le(h + 8, RESULT_RECORD_SIZE, 4);
+}
+
+static int file_header_ok(const unsigned char *h, size_t len) {
+    return len >= RESULT_HEADER_SIZE && memcmp(h, RESULT_MAGIC, 4) == 0 &&
+           get_le(h + 4, 4) == RESULT_VERSION && get_le(h + 8, 4) == RESULT_RECORD_SIZE;
+}
+
+void record_encode(const struct result *r, struct result_record *out) {
+    size_t i;
+
+    memset(out, 0, sizeof(*out));
+    for(i = 0; i < sizeof(r->name) && r->name[i] != '\0'; i++)
+        out->name[i] = r->name[i];
+    put_le(out->point, (uint64_t)(int64_t)r->point, 8);
+    put_le(out->year, (uint64_t)r->year, 2);
+    out->month = (unsigned char)r->month;
+    out->day = (unsigned char)r->day;
+    out->hour = (unsigned char)r->hour;
+    out->min = (unsigned char)r->min;
+    put_le(out->crc, crc32((const unsigned char *)out, offsetof(struct result_record, crc)), 4);
+}
+
+void record_decode(const struct result_record *rec, struct result *out) {
+    size_t i;
+
+    memset(out, 0, sizeof(*out));
+    for(i = 0; i < sizeof(out->name) - 1 && rec->name[i] != '\0'; i++)
+        out->name[i] = rec->name[i];
+    out->point = (long)record_point(rec);
+    out->year = (int)get_le(rec->year, 2);
+    out->month = rec->month;
+    out->day = rec->day;
+    out->hour = rec->hour;
+    out->min = rec->min;
+}
+
+int record_valid(const struct result_record *rec) {
+    return get_le(rec->crc, 4) == crc32((const unsigned char *)rec, offsetof(struct result_record, crc));
+}
+
+int64_t record_point(const struct result_record *rec) {
+    return (int64_t)get_le(rec->point, 8);
+}
+
+int records_open_view(struct record_view *v) {
+    v->records = NULL;
+    v->count = 0;
+    if(map_file(RESULT_FILE, &v->file) != 0) return 1;
+    if(v->file.size == 0) return 0;
+    if(!file_header_ok(v->file.data, v->file.size)) {
+        unmap_file(&v->file);
+        return 1;
+    }
+
+    /* 기록은 바이트 배열로만 되어 있어서 정렬 걱정 없이 그대로 가리킨다 */
+    v->records = (const struct result_record *)(v->file.data + RESULT_HEADER_SIZE);
+    v->count = (long)((v->file.size - RESULT_HEADER_SIZE) / RESULT_RECORD_SIZE);
+    return 0;
+}
+
+void records_close_view(struct record_view *v) {
+    unmap_file(&v->file);
+    v->records = NULL;
+    v->count = 0;
+}
+
+long records_count(void) {
+    unsigned char h[RESULT_HEADER_SIZE];
+    FILE *fp = fopen(RESULT_FILE, "rb");
+    long size;
+
+    if(fp == NULL) return 0;
+    if(fread(h, 1, sizeof(h), fp) != sizeof(h) || !file_header_ok(h, sizeof(h))) {
+        fclose(fp);
+        return 0;
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fclose(fp);
+
+    /* 마지막 기록이 덜 써졌으면 그 부분은 없는 셈 친다 */
+    return (size - RESULT_HEADER_SIZE) / RESULT_RECORD_SIZE;
+}
+
+int records_read(long record, struct result *out) {
+    struct result_record rec;
+    FILE *fp = fopen(RESULT_FILE, "rb");
+    int ok;
+
+    if(fp == NULL) return 1;
+    ok = fseek(fp, RESULT_HEADER_SIZE + record * (long)RESULT_RECORD_SIZE, SEEK_SET) == 0 &&
+         fread(&rec, sizeof(rec), 1, fp) == 1 && record_valid(&rec);
+    fclose(fp);
+
+    if(ok) record_decode(&rec, out);
+    return ok ? 0 : 1;
+}
+
+/* 헤더(새 파일일 때) 또는 모자란 칸 채우기 + 기록 하나를 buf에 만든다.
+ * 앞 기록이 덜 써진 채 끝났으면 0으로 채워 자리를 맞춘다. 그 칸은 체크섬이
+ * 맞지 않아 읽을 때 건너뛴다. 다른 프로세스의 쓰기도 항상 기록 단위라 끝의
+ * 어긋난 정도는 그 사이에 바뀌지 않는다 */
+static size_t build_append(unsigned char *buf, long size, const struct result *r) {
+    size_t len = 0;
+
+    if(size == 0) {
+        make_file_header(buf);
+        len = RESULT_HEADER_SIZE;
+    } else if(size > RESULT_HEADER_SIZE) {
+        len = (RESULT_RECORD_SIZE - (size - RESULT_HEADER_SIZE) % RESULT_RECORD_SIZE) % RESULT_RECORD_SIZE;
+        memset(buf, 0, len);
+    }
+    record_encode(r, (struct result_record *)(buf + len));
+    return len + RESULT_RECORD_SIZE;
+}
+
+#ifndef _WIN32
+/* 헤더를 다 쓴 임시 파일을 link로 걸어서, 헤더 없는 기록 파일이 보이는 순간이 없게 */
+static int create_result_file(void) {
+    unsigned char header[RESULT_HEADER_SIZE];
+    char tmp[64];
+    int fd, ok;
+
+    if(access(RESULT_FILE, F_OK) == 0) return 0;
+
+    make_file_header(header);
+    snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", RESULT_FILE, (long)getpid());
+    fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if(fd < 0) return 1;
+    ok = write(fd, header, sizeof(header)) == (ssize_t)sizeof(header);
+    close(fd);
+    /* 먼저 만든 프로세스가 있으면 EEXIST. 그 파일을 그대로 쓴다 */
+    if(ok && link(tmp, RESULT_FILE) != 0 && errno != EEXIST) ok = 0;
+    unlink(tmp);
+
+    return ok ? 0 : 1;
+}
+#endif
+
+/* 기록 파일이 예전 형식이면 1. 없거나 비었거나 지금 형식이면 0 */
+static int legacy_result_file(void) {
+    unsigned char header[RESULT_HEADER_SIZE];
+    FILE *in = fopen(RESULT_FILE, "rb");
+    size_t got;
+
+    if(in == NULL) return 0;
+    got = fread(header, 1, sizeof(header), in);
+    fclose(in);
+    return got > 0 && !file_header_ok(header, got);
+}
+
+int records_append(const struct result *r, long *record) {
+    unsigned char buf[RESULT_HEADER_SIZE + 2 * RESULT_RECORD_SIZE];
+    size_t len;
+    long end;
+    int ok;
+
+    /* 예전 형식 파일 뒤에 새 형식을 붙이면 안 되니 먼저 옮긴다 */
+    if(legacy_result_file() && records_migrate() < 0) return 1;
+
+#ifdef _WIN32
+    /* Windows에는 원자적인 덧붙이기가 없어서 끝 위치 확인부터 쓰기까지 잠근다 */
+    HANDLE file;
+    LARGE_INTEGER size;
+    DWORD written = 0;
+
+    file = CreateFileA(RESULT_FILE, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                       NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) return 1;
+    lock_handle(file, 1);
+    ok = GetFileSizeEx(file, &size) != 0;
+    if(ok) {
+        len = build_append(buf, (long)size.QuadPart, r);
+        ok = SetFilePointerEx(file, size, NULL, FILE_BEGIN) &&
+             WriteFile(file, buf, (DWORD)len, &written, NULL) && written == len;
+        end = (long)size.QuadPart + (long)len;
+    }
+    lock_handle(file, 0);
+    CloseHandle(file);
+#else
+    struct stat st;
+    ssize_t n;
+    int fd;
+
+    if(create_result_file() != 0) return 1;
+    fd = open(RESULT_FILE, O_WRONLY | O_APPEND);
+    if(fd < 0) return 1;
+    ok = fstat(fd, &st) == 0;
+    if(ok) {
+        /* 기록 하나(필요하면 채우기 포함)를 write 한 번으로. O_APPEND라 커널이
+         * 끝 위치를 잡고 쓰므로 동시에 저장해도 서로 섞이지 않는다 */
+        len = build_append(buf, (long)st.st_size, r);
+        do {
+            n = write(fd, buf, len);
+        } while(n < 0 && errno == EINTR);
+        /* 짧게 써졌으면 뒤를 이어 쓰지 않는다. 그 칸은 체크섬으로 걸러진다 */
+        ok = n == (ssize_t)len;
+        /* O_APPEND 쓰기 뒤의 위치는 방금 쓴 곳의 끝 */
+        end = (long)lseek(fd, 0, SEEK_CUR);
+    }
+    close(fd);
+#endif
+    if(!ok) return 1;
+
+    if(record != NULL) *record = (end - RESULT_HEADER_SIZE) / RESULT_RECORD_SIZE - 1;
+    score_index_update();
+    name_index_update();
+
+    return 0;
+}
+
+/* RESULT_LOCK_FILE을 잠근 채로 부른다 */
+static long migrate_locked(void) {
+    unsigned char header[RESULT_HEADER_SIZE];
+    char tmp[64];
+    struct result old;
+    struct result_record rec;
+    FILE *in, *out;
+    size_t got;
+    long n = 0;
+    int ok;
+
+    /* 잠금을 기다리는 동안 다른 프로세스가 옮겼을 수 있으니 다시 본다 */
+    in = fopen(RESULT_FILE, "rb");
+    if(in == NULL) return 0;
+    got = fread(header, 1, sizeof(header), in);
+    if(got == 0 || file_header_ok(header, got)) {
+        fclose(in);
+        return 0;
+    }
+
+    /* 예전 파일은 이 기계의 struct result 배열. 한 기록씩 읽어 옮긴다 */
+#ifdef _WIN32
+    snprintf(tmp, sizeof(tmp), "%s.%lu.new", RESULT_FILE, (unsigned long)GetCurrentProcessId());
+#else
+    snprintf(tmp, sizeof(tmp), "%s.%ld.new", RESULT_FILE, (long)getpid());
+#endif
+    out = fopen(tmp, "wb");
+    if(out == NULL) {
+        fclose(in);
+        return -1;
+    }
+    make_file_header(header);
+    fwrite(header, 1, sizeof(header), out);
+
+    rewind(in);
+    while(fread(&old, sizeof(old), 1, in) == 1) {
+        record_encode(&old, &rec);
+        fwrite(&rec, sizeof(rec), 1, out);
+        n++;
+    }
+    ok = !ferror(in) && !ferror(out);
+    fclose(in);
+    if(fclose(out) != 0) ok = 0;
+    if(!ok) {
+        remove(tmp);
+        return -1;
+    }
+
+    /* 원래 파일은 .bak으로 남겨 둔다. 옮기지 않고 링크를 하나 더 걸어서
+     * RESULT_FILE이 없는 순간이 없게 하고, 새 파일로는 한 번에 바꿔 끼운다.
+     * 그 사이에 저장하는 프로세스는 예전 형식을 보고 잠금에서 기다린다 */
+    remove(RESULT_FILE ".bak");
+#ifdef _WIN32
+    if(!CreateHardLinkA(RESULT_FILE ".bak", RESULT_FILE, NULL) ||
+       !MoveFileExA(tmp, RESULT_FILE, MOVEFILE_REPLACE_EXISTING)) {
+#else
+    if(link(RESULT_FILE, RESULT_FILE ".bak") != 0 || rename(tmp, RESULT_FILE) != 0) {
+#endif
+        remove(tmp);
+        return -1;
+    }
+
+    /* 색인은 기록 파일에서 다시 만든다 */
+    remove(SCORE_INDEX_FILE);
+    remove(NAME_INDEX_FILE);
+    remove(NAME_LINK_FILE);
+
+    return n;
+}
+
+long records_migrate(void) {
+    FILE *lock;
+    long n;
+
+    /* 보통은 이미 새 형식이라 잠그지 않고 끝 */
+    if(!legacy_result_file()) return 0;
+
+    lock = open_shared(RESULT_LOCK_FILE);
+    if(lock == NULL) return -1;
+    if(lock_file(lock) != 0) {
+        fclose(lock);
+        return -1;
+    }
+    n = migrate_locked();
+    unlock_file(lock);
+    fclose(lock);
+
+    return n;
+}
+
+/* 정렬 순서: 점수 내림차순, 같으면 기록 번호 오름차순 */
+static int entry_before(const struct score_entry *a, const struct score_entry *b) {
+    if(a->point != b->point) return a->point > b->point;
+    return a->record < b->record;
+}
+
+static int compare_entry(const void *a, const void *b) {
+    const struct score_entry *ea = a, *eb = b;
+    if(entry_before(ea, eb)) return -1;
+    if(entry_before(eb, ea)) return 1;
+    return 0;
+}
+
+/* 색인의 칸 번호. 0..SCORE_TOP_K-1이 상위, 그 뒤가 나머지 */
+static long entry_offset(long slot) {
+    return (long)sizeof(struct score_index_header) + slot * (long)sizeof(struct score_entry);
+}
+
+static int write_header(FILE *fp, const struct score_index_header *h) {
+    return fseek(fp, 0, SEEK_SET) == 0 && fwrite(h, sizeof(*h), 1, fp) == 1 && fflush(fp) == 0;
+}
+
+static void make_header(struct score_index_header *h) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, SCORE_INDEX_MAGIC, 4);
+    h->version = SCORE_INDEX_VERSION;
+}
+
+static int header_ok(const struct score_index_header *h) {
+    return memcmp(h->magic, SCORE_INDEX_MAGIC, 4) == 0 && h->version == SCORE_INDEX_VERSION &&
+           h->top <= SCORE_TOP_K && h->top <= h->count && h->sorted <= h->count - h->top &&
+           (h->top == SCORE_TOP_K || h->top == h->count);
+}
+
+/* 체크섬이 틀린 기록은 맨 뒤로 보낸다 */
+static void make_entry(const struct result_record *rec, long record, struct score_entry *e) {
+    e->point = record_valid(rec) ? record_point(rec) : INT64_MIN;
+    e->record = (uint32_t)record;
+    e->reserved = 0;
+}
+
+/* 기록 파일을 처음부터 읽어 색인을 제자리에서 새로 쓴다. 넣은 개수, 실패하면 -1.
+ * 전체를 정렬하므로 붙어 있던 꼬리도 정렬된 부분으로 들어간다.
+ * 파일을 줄이지는 않아서 매핑해 읽는 쪽이 끝 너머를 건드릴 일이 없다 */
+static long score_index_rebuild(FILE *fp, struct score_index_header *h, long total) {
+    struct score_entry *entries;
+    struct score_entry pad[SCORE_TOP_K];
+    struct record_view v;
+    long i = 0, top;
+
+    entries = malloc(sizeof(struct score_entry) * (total > 0 ? total : 1));
+    if(entries == NULL) return -1;
+
+    if(records_open_view(&v) == 0) {
+        for(i = 0; i < total && i < v.count; i++)
+            make_entry(&v.records[i], i, &entries[i]);
+        records_close_view(&v);
+    }
+    qsort(entries, i, sizeof(struct score_entry), compare_entry);
+
+    top = i < SCORE_TOP_K ? i : SCORE_TOP_K;
+    h->count = 0;
+    h->top = 0;
+    h->sorted = 0;
+    write_header(fp, h);
+    memset(pad, 0, sizeof(pad));
+    fwrite(entries, sizeof(struct score_entry), top, fp);
+    fwrite(pad, sizeof(struct score_entry), SCORE_TOP_K - top, fp);
+    fwrite(entries + top, sizeof(struct score_entry), i - top, fp);
+    free(entries);
+    if(fflush(fp) != 0) return -1;
+
+    h->count = (uint32_t)i;
+    h->top = (uint32_t)top;
+    h->sorted = (uint32_t)(i - top);
+    return i;
+}
+
+/* 새 기록 하나. 상위 안에 들면 상위 칸 안에서만 밀고, 밀려난 것이나 상위에
+ * 못 든 것은 꼬리 끝에 붙인다. 색인 크기와 상관없이 O(K) */
+static int score_index_add(FILE *fp, struct score_index_header *h, const struct score_entry *e) {
+    struct score_entry top[SCORE_TOP_K];
+    struct score_entry out = *e;
+    long pos, n = h->top;
+
+    if(fseek(fp, entry_offset(0), SEEK_SET) != 0 ||
+       fread(top, sizeof(struct score_entry), n, fp) != (size_t)n) return 1;
+
+    if(n < SCORE_TOP_K || entry_before(e, &top[n - 1])) {
+        /* 상위가 꽉 찼으면 맨 끝이 밀려난다 */
+        if(n == SCORE_TOP_K) out = top[--n];
+        for(pos = n; pos > 0 && entry_before(e, &top[pos - 1]); pos--)
+            top[pos] = top[pos - 1];
+        top[pos] = *e;
+        n++;
+        if(fseek(fp, entry_offset(pos), SEEK_SET) != 0 ||
+           fwrite(&top[pos], sizeof(struct score_entry), n - pos, fp) != (size_t)(n - pos)) return 1;
+        if(n > (long)h->top) {
+            h->top = (uint32_t)n;
+            h->count++;
+            return 0;
+        }
+    }
+
+    if(fseek(fp, entry_offset(SCORE_TOP_K + (h->count - h->top)), SEEK_SET) != 0 ||
+       fwrite(&out, sizeof(out), 1, fp) != 1) return 1;
+    h->count++;
+    return 0;
+}
+
+/* 잠그지 않고 헤더만 본다 */
+static int read_score_header(struct score_index_header *h) {
+    FILE *fp = fopen(SCORE_INDEX_FILE, "rb");
+    int ok;
+
+    if(fp == NULL) return 1;
+    ok = fread(h, sizeof(*h), 1, fp) == 1 && header_ok(h);
+    fclose(fp);
+    return ok ? 0 : 1;
+}
+
+/* 색인을 기록 파일에 맞춘다. 보통은 새로 저장된 기록 하나만 끼우면 된다 */
+int score_index_update(void) {
+    struct score_index_header h;
+    long total = records_count();
+    long count = -1, i;
+    uint32_t seq;
+    FILE *fp, *in;
+    int valid;
+
+    /* 이미 맞으면 잠그지 않고 끝 */
+    if(read_score_header(&h) == 0 && !(h.seq & 1) && h.count == total) return 0;
+
+    fp = open_shared(SCORE_INDEX_FILE);
+    if(fp == NULL) return 1;
+    if(lock_file(fp) != 0) {
+        fclose(fp);
+        return 1;
+    }
+
+    /* 잠금을 기다리는 동안 다른 프로세스가 맞춰 놨을 수 있으니 다시 읽는다 */
+    total = records_count();
+    valid = fread(&h, sizeof(h), 1, fp) == 1 && header_ok(&h);
+    if(valid && !(h.seq & 1) && h.count == total) {
+        unlock_file(fp);
+        fclose(fp);
+        return 0;
+    }
+
+    /* seq가 홀수인 채 남아 있으면 고치던 프로세스가 죽은 것 */
+    seq = ((valid ? h.seq : 0) + 1) | 1;
+    if(valid && !(h.seq & 1) && h.count <= total && total - h.count <= SCORE_INDEX_BATCH) {
+        h.seq = seq;
+        write_header(fp, &h);
+        in = fopen(RESULT_FILE, "rb");
+        if(in != NULL) {
+            fseek(in, RESULT_HEADER_SIZE + (long)h.count * (long)RESULT_RECORD_SIZE, SEEK_SET);
+            for(i = h.count; i < total; i++) {
+                struct result_record rec;
+                struct score_entry e;
+
+                if(fread(&rec, sizeof(rec), 1, in) != 1) break;
+                make_entry(&rec, i, &e);
+                if(score_index_add(fp, &h, &e) != 0) break;
+            }
+            fclose(in);
+            if(i == total) count = total;
+        }
+    }
+    if(count < 0) {
+        make_header(&h);
+        count = score_index_rebuild(fp, &h, total);
+    }
+
+    if(count >= 0) {
+        h.seq = seq + 1;
+        write_header(fp, &h);
+    }
+    unlock_file(fp);
+    fclose(fp);
+
+    return count == total ? 0 : 1;
+}
+
+/* 색인을 매핑해서 헤더와 항목 배열을 얻는다. capacity는 매핑 안에 들어 있는 칸 수 */
+static int map_score_index(struct mapped_file *m, const volatile struct score_index_header **h,
+                           const struct score_entry **entries, long *capacity) {
+    if(map_file(SCORE_INDEX_FILE, m) != 0) return 1;
+    if(m->size < sizeof(struct score_index_header)) {
+        unmap_file(m);
+        return 1;
+    }
+    *h = (const volatile struct score_index_header *)m->data;
+    *entries = (const struct score_entry *)(m->data + sizeof(struct score_index_header));
+    *capacity = (long)((m->size - sizeof(struct score_index_header)) / sizeof(struct score_entry));
+    return 0;
+}
+
+/* 상위 n개(최대 SCORE_TOP_K)의 기록 번호. 상위 칸만 읽는다 */
+long score_index_top(long n, long *records) {
+    int tries;
+
+    for(tries = 0; tries < SEQ_RETRIES; tries++) {
+        const volatile struct score_index_header *h;
+        const struct score_entry *entries;
+        struct mapped_file m;
+        long count, i;
+        uint32_t seq;
+
+        if(map_score_index(&m, &h, &entries, &count) != 0) return 0;
+        seq = seq_begin(&h->seq);
+        /* 매핑한 뒤에 늘어난 부분은 안 보이니 매핑 크기 안으로 자른다 */
+        if(h->top < count) count = h->top;
+        for(i = 0; i < n && i < count; i++)
+            records[i] = entries[i].record;
+        if(!seq_retry(&h->seq, seq)) {
+            unmap_file(&m);
+            return i;
+        }
+        unmap_file(&m);
+        seq_pause();
+    }
+    return 0;
+}
+
+/* entries[0..n) (내림차순) 중 point보다 높은 개수 */
+static long count_above(const struct score_entry *entries, long n, long point) {
+    long lo = 0, hi = n;
+
+    while(lo < hi) {
+        long mid = lo + (hi - lo) / 2;
+        if(entries[mid].point > point)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* 이 점수가 몇 등인지 (더 높은 점수 개수 + 1). 정렬된 곳은 이진 탐색,
+ * 다시 만든 뒤에 붙은 꼬리만 훑는다 */
+long score_rank(long point) {
+    int tries;
+
+    for(tries = 0; tries < SEQ_RETRIES; tries++) {
+        const volatile struct score_index_header *h;
+        const struct score_entry *entries, *rest;
+        struct mapped_file m;
+        long capacity, top, sorted, tail, above, i;
+        uint32_t seq;
+
+        if(map_score_index(&m, &h, &entries, &capacity) != 0) return 1;
+        seq = seq_begin(&h->seq);
+        top = h->top;
+        sorted = h->sorted;
+        tail = (long)h->count - top - sorted;
+        if(top > capacity) top = capacity;
+        /* 나머지는 상위 칸 뒤에서 시작한다. 매핑 밖은 안 본다 */
+        capacity = capacity > SCORE_TOP_K ? capacity - SCORE_TOP_K : 0;
+        if(sorted > capacity) sorted = capacity;
+        if(tail > capacity - sorted) tail = capacity - sorted;
+        if(tail < 0) tail = 0;
+
+        rest = entries + SCORE_TOP_K;
+        above = count_above(entries, top, point);
+        if(sorted > 0) above += count_above(rest, sorted, point);
+        for(i = 0; i < tail; i++)
+            if(rest[sorted + i].point > point) above++;
+
+        if(!seq_retry(&h->seq, seq)) {
+            unmap_file(&m);
+            return above + 1;
+        }
+        unmap_file(&m);
+        seq_pause();
+    }
+    return 1;
+}
@@ -0,0 +1,130 @@
+#ifndef TETRIS_RECORDS_H
+#define TETRIS_RECORDS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define RESULT_FILE "tetris_result.dat"
+#define SCORE_INDEX_FILE "tetris_result.idx"
+#define RESULT_LOCK_FILE "tetris_result.lock"   /* 예전 형식 옮기는 동안 잡는 잠금 */
+
+/* 메모리에서 쓰는 기록. 예전 기록 파일은 이 구조체를 그대로 fwrite한 것이었다 */
+struct result {
+    char name[30];
+    long point;
+    int year;
+    int month;
+    int day;
+    int hour;
+    int min;
+    int rank;
+};
+
+/* 기록 파일 형식 (버전 1)
+ *   헤더 16바이트: "TRES", 버전(u32), 기록 크기(u32), 예약(u32)
+ *   기록 64바이트: 이름 32바이트(남는 칸 0), 점수 i64, 연도 u16, 월/일/시/분 u8,
+ *                  예약 14바이트(0), 앞 60바이트의 CRC32
+ * 정수는 전부 리틀 엔디언이고 구조체에 빈 칸이 없어서, 어느 기계에서 쓴 파일이든
+ * 그대로 매핑해서 읽을 수 있다. 체크섬 단위는 기록 하나라서 저장은 계속
+ * 기록 하나를 붙이는 쓰기 한 번으로 끝난다. */
+#define RESULT_MAGIC "TRES"
+#define RESULT_VERSION 1
+#define RESULT_HEADER_SIZE 16
+#define RESULT_RECORD_SIZE 64
+#define RESULT_NAME_SIZE 32
+
+struct result_record {
+    char name[RESULT_NAME_SIZE];
+    unsigned char point[8];
+    unsigned char year[2];
+    unsigned char month, day, hour, min;
+    unsigned char reserved[14];
+    unsigned char crc[4];
+};
+
+/* 기록 하나 인코딩/디코딩. 체크섬이 틀린 기록은 record_valid가 0 */
+void record_encode(const struct result *r, struct result_record *out);
+void record_decode(const struct result_record *rec, struct result *out);
+int record_valid(const struct result_record *rec);
+int64_t record_point(const struct result_record *rec);
+
+/* 점수 색인 파일
+ * tetris_result.dat의 기록 번호를 점수 내림차순(같으면 먼저 저장된 순)으로 둔다.
+ *   앞쪽 SCORE_TOP_K칸: 상위 top개, 항상 정렬 (남는 칸은 0)
+ *   그 뒤: 나머지. 처음 sorted개는 다시 만들 때 정렬해 둔 것이고, 그 뒤는
+ *          저장된 순서대로 붙기만 한다 (상위에서 밀려난 것도 여기로)
+ * 그래서 저장 하나는 상위 K칸 안에서만 자리를 찾고 나머지는 끝에 붙여서 O(K).
+ * 순위는 상위와 정렬된 부분은 이진 탐색, 붙은 꼬리는 훑어서 센다.
+ * 헤더의 count는 색인에 들어간 기록 수라서, 기록 파일보다 뒤처져 있으면
+ * 모자란 만큼만 넣고 맞지 않으면 기록 파일에서 다시 만든다 (이때 꼬리도 정렬된다).
+ * 고치는 쪽은 파일 잠금을 잡고 seq를 홀수로 만든 뒤 쓰고, 끝나면 짝수로 올린다. */
+#define SCORE_INDEX_MAGIC "TIDX"
+#define SCORE_INDEX_VERSION 2
+#define SCORE_TOP_K 64          /* score_index_top으로 한 번에 볼 수 있는 최대 개수 */
+
+struct score_index_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t seq;           /* 고치는 중이면 홀수 */
+    uint32_t top;           /* 상위 칸에 든 개수, count가 K보다 작을 때만 K보다 작다 */
+    uint32_t sorted;        /* 상위 뒤에서 정렬된 부분의 길이 */
+};
+
+struct score_entry {
+    int64_t point;
+    uint32_t record;
+    uint32_t reserved;
+};
+
+/* 여러 프로세스가 같은 파일을 쓸 때
+ * 기록은 O_APPEND 쓰기 한 번으로 붙이고, 색인은 고치는 프로세스만 파일 잠금을
+ * 잡는다. 읽는 쪽은 잠그지 않고 색인 헤더의 seq를 읽기 전후로 확인해서 둘이 같은
+ * 짝수일 때만 읽은 내용을 쓴다. */
+#define SEQ_RETRIES 100
+
+FILE *open_shared(const char *path);   /* 읽기/쓰기, 없으면 만들고 자르지 않는다 */
+int lock_file(FILE *fp);
+void unlock_file(FILE *fp);
+
+uint32_t seq_begin(const volatile uint32_t *seq);
+int seq_retry(const volatile uint32_t *seq, uint32_t start);   /* 다시 읽어야 하면 1 */
+void seq_pause(void);
+
+/* 읽기 전용 메모리 매핑. 빈 파일이면 data가 NULL, size가 0 */
+struct mapped_file {
+    const unsigned char *data;
+    size_t size;
+};
+
+int map_file(const char *path, struct mapped_file *m);
+void unmap_file(struct mapped_file *m);
+
+/* 기록 파일을 매핑해서 복사 없이 기록 배열로 본다.
+ * 덜 써진 마지막 기록은 count에서 빠진다. 헤더가 틀리면 실패 */
+struct record_view {
+    struct mapped_file file;
+    const struct result_record *records;
+    long count;
+};
+
+int records_open_view(struct record_view *v);
+void records_close_view(struct record_view *v);
+
+/* 기록 파일 */
+long records_count(void);
+int records_read(long record, struct result *out);
+int records_append(const struct result *r, long *record);
+
+/* 예전 형식(struct result를 그대로 쓴 파일)이면 새 형식으로 옮긴다.
+ * 옮기는 동안은 RESULT_LOCK_FILE을 잠가서 한 프로세스만 옮긴다.
+ * 옮긴 기록 수, 이미 새 형식이거나 파일이 없으면 0, 실패하면 -1 */
+long records_migrate(void);
+
+/* 점수 색인 */
+int score_index_update(void);
+long score_index_top(long n, long *records);
+long score_rank(long point);
+
+#endif
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+    #include <errno.h>
+#endif
+
+#include "engine.h"
+#include "render.h"
+
+/* 칸 종류 */
+#define GLYPH_EMPTY 0
+#define GLYPH_WALL 1
+#define GLYPH_LOCKED 2
+#define GLYPH_ACTIVE 3
+#define GLYPH_GHOST 4
+#define GLYPH_NEXT 5
+#define GLYPH_UNKNOWN 0xFF
+
+#ifdef _WIN32
+static const char *glyphs[] = { "  ", "||", "[]", "##", "--", "[]" };
+#else
+static const char *glyphs[] = { "  ", "⬜", "🟩", "🟥", "⬛", "🟥" };
+#endif
+
+/* 화면 배치 (터미널 좌표는 1부터) */
+#define NEXT_ROW 4
+#define BOARD_ROW 9
+#define CELL_COL 5
+#define SCORE_ROW (BOARD_ROW + BOARD_HEIGHT + 2)
+
+static void put(struct renderer *r, const char *s) {
+    size_t n = strlen(s);
+    if(r->len + n > sizeof(r->buf)) n = sizeof(r->buf) - r->len;
+    memcpy(r->buf + r->len, s, n);
+    r->len += n;
+}
+
+static void put_fmt(struct renderer *r, const char *fmt, ...) {
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(r->buf + r->len, sizeof(r->buf) - r->len, fmt, ap);
+    va_end(ap);
+    if(n > 0) {
+        r->len += (size_t)n;
+        if(r->len > sizeof(r->buf)) r->len = sizeof(r->buf);
+    }
+}
+
+/* 현재 상태로 화면 모델 만들기 */
+static void build_frame(struct frame *f, const struct game_state *g, long best_point) {
+    const struct block_shape *next = &block_table[g->next_block_number][0];
+    int i, j;
+
+    memset(f, 0, sizeof(*f));
+    for(i = 0; i <= BOARD_HEIGHT; i++) {
+        /* 움직이는 블록과 고스트는 위치에서 바로 만들어 보드 위에 얹는다.
+         * 고스트는 블록과 같은 자리면 그리지 않는다 */
+        row_t active = 0, ghost = 0;
+        if(i < BOARD_HEIGHT) {
+            active = piece_row(g->block_number, g->block_state, g->x, g->y, i);
+            if(g->ghost_y != g->y)
+                ghost = piece_row(g->block_number, g->block_state, g->x, g->ghost_y, i);
+        }
+        for(j = 0; j < BOARD_COLS; j++) {
+            if(j == 0 || j == RIGHT_WALL || i == BOARD_HEIGHT)
+                f->cell[i][j] = GLYPH_WALL;
+            else if(CELL_SET(active, j))
+                f->cell[i][j] = GLYPH_ACTIVE;
+            else if(CELL_SET(g->tetris_table[i], j))
+                f->cell[i][j] = GLYPH_LOCKED;
+            else if(CELL_SET(ghost, j))
+                f->cell[i][j] = GLYPH_GHOST;
+            else
+                f->cell[i][j] = GLYPH_EMPTY;
+        }
+    }
+
+    for(i = 0; i < 4; i++)
+        for(j = 0; j < 4; j++)
+            f->next[i][j] = ((next->row_mask[i] >> j) & 1) ? GLYPH_NEXT : GLYPH_EMPTY;
+
+    f->point = g->point;
+    f->best_point = best_point;
+    f->level = g->level;
+    f->lines = g->lines;
+}
+
+/* 바뀐 칸만 커서를 옮겨 그리기. 바로 옆 칸이 이어지면 커서 이동은 생략 */
+static void diff_cells(struct renderer *r, const unsigned char *now, const unsigned char *last,
+                       int rows, int cols, int top, int *cur_row, int *cur_col) {
+    int i, j;
+
+    for(i = 0; i < rows; i++) {
+        for(j = 0; j < cols; j++) {
+            int k = i * cols + j;
+            int row = top + i;
+            int col = CELL_COL + j * 2;
+
+            if(now[k] == last[k]) continue;
+            if(row != *cur_row || col != *cur_col)
+                put_fmt(r, "\033[%d;%dH", row, col);
+            put(r, glyphs[now[k]]);
+            *cur_row = row;
+            *cur_col = col + 2;
+        }
+    }
+}
+
+void render_reset(struct renderer *r) {
+    r->valid = 0;
+    r->len = 0;
+}
+
+size_t render_frame(struct renderer *r, const struct game_state *g, long best_point) {
+    struct frame now;
+    int cur_row = -1, cur_col = -1;
+
+    r->len = 0;
+    if(g->next_block_number < I_BLOCK || g->next_block_number > O_BLOCK) return 0;
+
+    build_frame(&now, g, best_point);
+    if(r->valid && memcmp(&now, &r->last, sizeof(now)) == 0) return 0;
+
+    /* 처음이면 화면을 지우고 고정 문구부터 */
+    if(!r->valid) {
+        memset(&r->last, GLYPH_UNKNOWN, sizeof(r->last));
+        r->last.point = -1;
+        r->last.best_point = -1;
+        r->last.level = -1;
+        r->last.lines = -1;
+        put(r, "\033[2J\033[H");
+        put(r, "<< TETRIS >>\n\nNext Block\n");
+        put_fmt(r, "\033[%d;1H", SCORE_ROW + 3);
+        put(r, "Controls: J(left) L(right) K(down) I(rotate) A(drop) P(quit)\n");
+        put(r, "Ghost block shows where your piece will land\n");
+        r->valid = 1;
+    }
+
+    diff_cells(r, &now.next[0][0], &r->last.next[0][0], 4, 4, NEXT_ROW, &cur_row, &cur_col);
+    diff_cells(r, &now.cell[0][0], &r->last.cell[0][0], BOARD_HEIGHT + 1, BOARD_COLS, BOARD_ROW, &cur_row, &cur_col);
+
+    if(now.point != r->last.point)
+        put_fmt(r, "\033[%d;1HCurrent Score: %ld\033[K", SCORE_ROW, now.point);
+    if(now.best_point != r->last.best_point)
+        put_fmt(r, "\033[%d;1HBest Score: %ld\033[K", SCORE_ROW + 1, now.best_point);
+    if(now.level != r->last.level || now.lines != r->last.lines)
+        put_fmt(r, "\033[%d;1HLevel: %d  Lines: %ld\033[K", SCORE_ROW + 2, now.level, now.lines);
+    r->last = now;
+
+    /* 커서는 화면 아래에 두기 */
+    put_fmt(r, "\033[%d;1H", SCORE_ROW + 5);
+
+    return r->len;
+}
+
+void render_flush(struct renderer *r) {
+#ifdef _WIN32
+    fwrite(r->buf, 1, r->len, stdout);
+    fflush(stdout);
+#else
+    size_t done = 0;
+
+    fflush(stdout);
+    while(done < r->len) {
+        ssize_t n = write(STDOUT_FILENO, r->buf + done, r->len - done);
+        if(n < 0) {
+            if(errno == EINTR) continue;
+            break;
+        }
+        done += (size_t)n;
+    }
+#endif
+    r->len = 0;
+}
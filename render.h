@@ -0,0 +1,38 @@
+#ifndef TETRIS_RENDER_H
+#define TETRIS_RENDER_H
+
+#include <stddef.h>
+
+#include "engine.h"
+
+/* 전체를 다시 그릴 때 칸마다 글리프(최대 4바이트)와 커서 이동이 들어갈 만큼 */
+#define RENDER_BUF_SIZE (8192 + (BOARD_HEIGHT + 1) * BOARD_COLS * 16)
+
+/* 화면에 그려진 내용. 칸마다 글리프 번호를 기억해 두고 바뀐 칸만 다시 그린다 */
+struct frame {
+    unsigned char cell[BOARD_HEIGHT + 1][BOARD_COLS];   /* 바닥 줄 포함 */
+    unsigned char next[4][4];
+    long point;
+    long best_point;
+    int level;
+    long lines;
+};
+
+struct renderer {
+    struct frame last;      /* 마지막으로 터미널에 보낸 화면 */
+    int valid;              /* 0이면 다음 프레임은 전체를 다시 그림 */
+    char buf[RENDER_BUF_SIZE];
+    size_t len;
+};
+
+/* 다음 프레임은 화면을 지우고 처음부터 그리게 한다 */
+void render_reset(struct renderer *r);
+
+/* 현재 상태를 직전 프레임과 비교해 바뀐 부분만 r->buf에 담고 길이를 반환.
+ * 바뀐 게 없으면 0 */
+size_t render_frame(struct renderer *r, const struct game_state *g, long best_point);
+
+/* r->buf를 write() 한 번으로 내보낸다 */
+void render_flush(struct renderer *r);
+
+#endif
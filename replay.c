@@ -0,0 +1,190 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+    #include <direct.h>
+    #include <io.h>
+    #include <sys/stat.h>
+    #define MAKE_DIR(path) _mkdir(path)
+#else
+    #include <sys/stat.h>
+    #include <sys/types.h>
+    #include <unistd.h>
+    #define MAKE_DIR(path) mkdir(path, 0755)
+#endif
+
+/* 같은 이름이 이미 있으면 뒤에 -1, -2 ... 를 붙여 본다 */
+#define REPLAY_NAME_TRIES 100
+
+#include "engine.h"
+#include "replay.h"
+
+/* 부호 없는 LEB128: 7비트씩, 이어지면 최상위 비트 1 */
+static int put_varint(unsigned char *buf, uint64_t v) {
+    int n = 0;
+    while(v >= 0x80) {
+        buf[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    buf[n++] = (unsigned char)v;
+    return n;
+}
+
+/* 쓰다가 실패하면 (디스크가 꽉 참 등) 기록을 멈추고 덜 써진 파일은 지운다 */
+static void stop_recording(struct replay_writer *w) {
+    fclose(w->fp);
+    remove(w->path);
+    w->fp = NULL;
+}
+
+static int write_varint(struct replay_writer *w, uint64_t v) {
+    unsigned char buf[10];
+    size_t n = (size_t)put_varint(buf, v);
+    return fwrite(buf, 1, n, w->fp) == n;
+}
+
+/* 없는 파일일 때만 만든다. 다른 프로세스가 같은 이름을 쓰고 있으면 NULL, errno는 EEXIST */
+static FILE *create_new(const char *path) {
+#ifdef _WIN32
+    int fd = _open(path, _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+    FILE *fp;
+    if(fd < 0) return NULL;
+    fp = _fdopen(fd, "wb");
+    if(fp == NULL) _close(fd);
+#else
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    FILE *fp;
+    if(fd < 0) return NULL;
+    fp = fdopen(fd, "wb");
+    if(fp == NULL) close(fd);
+#endif
+    return fp;
+}
+
+int replay_open(struct replay_writer *w, uint64_t seed, int randomizer, int leveling) {
+    unsigned char header[REPLAY_HEADER_SIZE];
+    char base[96];
+    time_t t = time(NULL);
+    struct tm *tm = localtime(&t);
+    int i;
+
+    w->fp = NULL;
+    w->last_tick = 0;
+
+    MAKE_DIR(REPLAY_DIR);
+    snprintf(base, sizeof(base), "%s/%04d%02d%02d-%02d%02d%02d-%016llx", REPLAY_DIR,
+             tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday,
+             tm->tm_hour, tm->tm_min, tm->tm_sec, (unsigned long long)seed);
+
+    /* 같은 초에 같은 시드로 시작한 게임이 있어도 서로 덮어쓰지 않게 */
+    for(i = 0; i < REPLAY_NAME_TRIES && w->fp == NULL; i++) {
+        if(i == 0) snprintf(w->path, sizeof(w->path), "%s.trp", base);
+        else snprintf(w->path, sizeof(w->path), "%s-%d.trp", base, i);
+        w->fp = create_new(w->path);
+        if(w->fp == NULL && errno != EEXIST) break;
+    }
+    if(w->fp == NULL) return 1;
+
+    memcpy(header, REPLAY_MAGIC, 4);
+    header[4] = REPLAY_VERSION;
+    header[5] = (unsigned char)(randomizer | (leveling ? REPLAY_LEVELING : 0));
+    for(i = 0; i < 8; i++)
+        header[6 + i] = (unsigned char)(seed >> (8 * i));
+    if(fwrite(header, 1, sizeof(header), w->fp) != sizeof(header) || fflush(w->fp) != 0) {
+        stop_recording(w);
+        return 1;
+    }
+
+    return 0;
+}
+
+void replay_event(struct replay_writer *w, long tick, int command) {
+    if(w->fp == NULL) return;
+
+    /* 게임 도중에 꺼져도 거기까지는 남도록 입력마다 내보낸다 */
+    if(!write_varint(w, ((uint64_t)(tick - w->last_tick) << 3) | (unsigned)command) ||
+       fflush(w->fp) != 0) {
+        stop_recording(w);
+        return;
+    }
+    w->last_tick = tick;
+}
+
+void replay_close(struct replay_writer *w, long tick, long point) {
+    if(w->fp == NULL) return;
+
+    if(!write_varint(w, ((uint64_t)(tick - w->last_tick) << 3) | REPLAY_END) ||
+       !write_varint(w, (uint64_t)point) || fflush(w->fp) != 0) {
+        stop_recording(w);
+        return;
+    }
+    if(fclose(w->fp) != 0) remove(w->path);
+    w->fp = NULL;
+}
+
+static int get_varint(const unsigned char **p, const unsigned char *end, uint64_t *v) {
+    int shift = 0;
+    *v = 0;
+    while(*p < end && shift < 64) {
+        unsigned char b = *(*p)++;
+        *v |= (uint64_t)(b & 0x7F) << shift;
+        if(!(b & 0x80)) return 1;
+        shift += 7;
+    }
+    return 0;
+}
+
+int replay_verify(const unsigned char *data, size_t len, long *stored, long *replayed) {
+    struct game_state g;
+    const unsigned char *p = data + REPLAY_HEADER_SIZE;
+    const unsigned char *end = data + len;
+    uint64_t seed = 0;
+    long tick = 0;
+    int i, rules;
+
+    *stored = *replayed = 0;
+    if(len < REPLAY_HEADER_SIZE || memcmp(data, REPLAY_MAGIC, 4) != 0) return REPLAY_BAD;
+    /* 버전 1은 레벨 없이 고정 속도 */
+    if(data[4] < 1 || data[4] > REPLAY_VERSION) return REPLAY_BAD;
+    rules = data[5] & ~REPLAY_LEVELING;
+    if(rules > RANDOMIZER_BAG || (data[4] == 1 && rules != data[5])) return REPLAY_BAD;
+    for(i = 0; i < 8; i++)
+        seed |= (uint64_t)data[6 + i] << (8 * i);
+
+    game_init(&g, seed, rules);
+    g.leveling = (data[5] & REPLAY_LEVELING) != 0;
+
+    for(;;) {
+        uint64_t v;
+        int command;
+        long target;
+
+        if(!get_varint(&p, end, &v)) return REPLAY_BAD;
+        command = (int)(v & 7);
+        /* 파일에서 읽은 값이라 더하기 전에 long 범위부터 확인 */
+        if((v >> 3) > (uint64_t)(LONG_MAX - tick)) return REPLAY_BAD;
+        target = tick + (long)(v >> 3);
+
+        /* 입력 사이의 중력을 먼저 적용. 게임이 끝났으면 남은 틱은 건너뜀 */
+        while(tick < target && g.game == GAME_START) {
+            gravity_step(&g);
+            tick++;
+        }
+        tick = target;
+
+        if(command == REPLAY_END) {
+            if(!get_varint(&p, end, &v)) return REPLAY_BAD;
+            *stored = (long)v;
+            *replayed = g.point;
+            return *stored == *replayed ? REPLAY_OK : REPLAY_MISMATCH;
+        }
+        if(command > QUIT) return REPLAY_BAD;
+        if(g.game == GAME_START) game_command(&g, command);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef TETRIS_REPLAY_H
+#define TETRIS_REPLAY_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* 리플레이 파일 형식
+ *   헤더: "TRPL", 버전 1바이트, 규칙 1바이트, 시드 8바이트(LE)
+ *         규칙은 블록 생성 방식 | REPLAY_LEVELING (레벨 곡선과 20G, 버전 2부터)
+ *   이벤트: varint((앞 이벤트와의 중력 틱 차이 << 3) | 명령)
+ *           명령은 LEFT/RIGHT/DOWN/ROTATE/HARD_DROP/QUIT
+ *   끝: varint((틱 차이 << 3) | REPLAY_END), varint(최종 점수)
+ * 시간은 중력으로 한 칸 내려간 횟수(틱)로 센다. 입력 사이에 중력이 몇 번
+ * 있었는지만 알면 같은 게임이 그대로 다시 나온다. 레벨이 올라 중력이 빨라져도
+ * 틱 수만 늘어날 뿐 실제 시간은 기록하지 않는다. */
+#define REPLAY_MAGIC "TRPL"
+#define REPLAY_VERSION 2
+#define REPLAY_LEVELING 0x10
+#define REPLAY_HEADER_SIZE 14
+#define REPLAY_END 7
+
+#define REPLAY_DIR "replays"
+
+struct replay_writer {
+    FILE *fp;
+    long last_tick;
+    char path[128];
+};
+
+/* 리플레이 파일을 새로 만들고 헤더를 쓴다. 실패하면 w->fp가 NULL이고 기록은 건너뜀.
+ * 도중에 쓰기가 실패해도 기록을 멈추고 덜 써진 파일은 지운다 */
+int replay_open(struct replay_writer *w, uint64_t seed, int randomizer, int leveling);
+
+/* 입력 하나를 바로 파일 끝에 붙인다 */
+void replay_event(struct replay_writer *w, long tick, int command);
+
+/* 끝 표시와 최종 점수를 쓰고 닫는다 */
+void replay_close(struct replay_writer *w, long tick, long point);
+
+/* 검증 결과 */
+#define REPLAY_OK 0
+#define REPLAY_MISMATCH 1       /* 다시 돌린 점수가 기록된 점수와 다름 */
+#define REPLAY_BAD 2            /* 헤더가 틀렸거나 중간에 잘림 */
+
+/* 메모리에 올린 리플레이를 화면 없이 다시 돌려서 기록된 점수와 비교 */
+int replay_verify(const unsigned char *data, size_t len, long *stored, long *replayed);
+
+#endif
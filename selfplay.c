@@ -0,0 +1,153 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "engine.h"
+#include "movegen.h"
+#include "pool.h"
+#include "selfplay.h"
+
+/* 결과는 워커별로 모았다가 마지막에 합친다. 캐시 줄을 나눠 쓰지 않게 띄워 둠 */
+struct selfplay_stats {
+    long games;
+    long pieces;
+    long total_point;
+    long best_point;
+    char pad[64 - 4 * sizeof(long)];
+};
+
+struct selfplay {
+    struct selfplay_stats *stats;
+    uint64_t seed;
+    int randomizer;
+};
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* 보드 평가: 지운 점수 - 구멍 - 높이 - 울퉁불퉁함 */
+static long evaluate(const struct game_state *g, long gained) {
+    int top[BOARD_COLS];
+    long holes = 0, height = 0, bump = 0;
+    int i, c;
+
+    for(c = 1; c <= BOARD_WIDTH; c++) {
+        top[c] = BOARD_HEIGHT;
+        for(i = 0; i < BOARD_HEIGHT; i++) {
+            if(CELL_SET(g->tetris_table[i], c)) {
+                if(top[c] == BOARD_HEIGHT) top[c] = i;
+            } else if(top[c] != BOARD_HEIGHT) {
+                holes++;
+            }
+        }
+        height += BOARD_HEIGHT - top[c];
+        if(c > 1) bump += abs(top[c] - top[c - 1]);
+    }
+
+    return gained - holes * 50 - height * 5 - bump * 2;
+}
+
+/* 간단한 탐욕 봇: 도달 가능한 모든 최종 위치 중 평가가 가장 좋은 곳에 놓는다.
+ * 위치 생성기가 실제 조작으로 갈 수 있는 곳만 주므로 바로 그 자리에 굳힌다. */
+static void bot_play_piece(struct game_state *g) {
+    struct placement moves[MAX_PLACEMENTS];
+    long best = 0;
+    int best_move = -1;
+    int n, i;
+
+    n = enumerate_placements(g, moves);
+    for(i = 0; i < n; i++) {
+        struct game_state t;
+        long eval;
+
+        memcpy(&t, g, sizeof(t));
+        t.block_state = moves[i].block_state;
+        t.x = moves[i].x;
+        t.y = moves[i].y;
+        place_block(&t);
+        eval = evaluate(&t, t.point - g->point);
+        if(best_move < 0 || eval > best) {
+            best = eval;
+            best_move = i;
+        }
+    }
+
+    if(best_move < 0) {
+        drop(g);
+        return;
+    }
+    g->block_state = moves[best_move].block_state;
+    g->x = moves[best_move].x;
+    g->y = moves[best_move].y;
+    lock_block(g);
+}
+
+static void play_one_game(void *ctx, int worker, long job) {
+    struct selfplay *sp = ctx;
+    struct selfplay_stats *st = &sp->stats[worker];
+    struct game_state g;
+    uint64_t seed = sp->seed + (uint64_t)job;
+    long pieces = 0;
+
+    /* 게임 번호로 시드를 정하므로 어느 스레드가 돌려도 결과가 같다 */
+    game_init(&g, rng_next(&seed), sp->randomizer);
+    while(g.game == GAME_START && pieces < SELFPLAY_MAX_PIECES) {
+        bot_play_piece(&g);
+        pieces++;
+    }
+
+    st->games++;
+    st->pieces += pieces;
+    st->total_point += g.point;
+    if(g.point > st->best_point) st->best_point = g.point;
+}
+
+int run_selfplay(long games, int threads, uint64_t seed, int randomizer) {
+    struct selfplay sp;
+    long pieces = 0, total_point = 0, best_point = 0, done = 0;
+    double start, elapsed;
+    int i;
+
+    if(games <= 0) return 1;
+    if(threads <= 0) threads = cpu_count();
+
+    sp.seed = seed;
+    sp.randomizer = randomizer;
+    sp.stats = calloc(threads, sizeof(struct selfplay_stats));
+    if(sp.stats == NULL) {
+        printf("Memory allocation failed!\n");
+        return 1;
+    }
+
+    start = now_sec();
+    threads = pool_run(games, threads, play_one_game, &sp);
+    elapsed = now_sec() - start;
+
+    for(i = 0; i < threads; i++) {
+        struct selfplay_stats *st = &sp.stats[i];
+        done += st->games;
+        pieces += st->pieces;
+        total_point += st->total_point;
+        if(st->best_point > best_point) best_point = st->best_point;
+    }
+    free(sp.stats);
+
+    if(elapsed <= 0) elapsed = 1e-9;
+    printf("selfplay: %ld games on %d threads\n", done, threads);
+    printf("seed: %llu (%s)\n", (unsigned long long)seed,
+           randomizer == RANDOMIZER_BAG ? "7-bag" : "uniform");
+    printf("elapsed: %.3f s\n", elapsed);
+    printf("pieces: %ld\n", pieces);
+    printf("games/sec: %.1f\n", done / elapsed);
+    printf("pieces/sec: %.0f\n", pieces / elapsed);
+    printf("avg score: %.1f\n", done ? (double)total_point / done : 0.0);
+    printf("best score: %ld\n", best_point);
+
+    return 0;
+}
@@ -0,0 +1,12 @@
+#ifndef TETRIS_SELFPLAY_H
+#define TETRIS_SELFPLAY_H
+
+#include <stdint.h>
+
+#define SELFPLAY_MAX_PIECES 10000   /* 한 게임당 최대 블록 수 (무한 게임 방지) */
+
+/* 화면 출력이나 대기 없이 games판을 threads개 스레드로 돌리고 결과를 출력.
+ * i번째 게임의 블록 순서는 seed와 i로 정해진다 */
+int run_selfplay(long games, int threads, uint64_t seed, int randomizer);
+
+#endif
@@ -0,0 +1,30 @@
+#include <string.h>
+
+#include "snapshot.h"
+
+void snapshot_init(struct snapshot_slot *s) {
+    memset(s, 0, sizeof(*s));
+    s->back = 0;
+    s->front = 1;
+    __atomic_store_n(&s->middle, 2, __ATOMIC_RELEASE);
+}
+
+struct snapshot *snapshot_back(struct snapshot_slot *s) {
+    return &s->buf[s->back];
+}
+
+/* 채운 버퍼를 가운데로 내놓고, 가운데 있던 것을 다음에 쓸 버퍼로 가져온다.
+ * RELEASE라서 읽는 쪽이 번호를 보면 내용도 다 보인다 */
+void snapshot_publish(struct snapshot_slot *s) {
+    int old = __atomic_exchange_n(&s->middle, s->back | SNAPSHOT_FRESH, __ATOMIC_ACQ_REL);
+    s->back = old & ~SNAPSHOT_FRESH;
+}
+
+const struct snapshot *snapshot_latest(struct snapshot_slot *s) {
+    int old;
+
+    if(!(__atomic_load_n(&s->middle, __ATOMIC_ACQUIRE) & SNAPSHOT_FRESH)) return NULL;
+    old = __atomic_exchange_n(&s->middle, s->front, __ATOMIC_ACQ_REL);
+    s->front = old & ~SNAPSHOT_FRESH;
+    return &s->buf[s->front];
+}
@@ -0,0 +1,37 @@
+#ifndef TETRIS_SNAPSHOT_H
+#define TETRIS_SNAPSHOT_H
+
+#include "engine.h"
+
+/* 시뮬레이션 스레드가 만든 상태를 렌더 스레드에 넘기는 칸 하나
+ * 버퍼 세 개를 돌려 쓴다: 쓰는 쪽 것, 읽는 쪽 것, 가운데 것. 쓰는 쪽은 다 채운
+ * 버퍼를 가운데와 원자적으로 맞바꾸고, 읽는 쪽은 새 것이 있을 때만 가운데와
+ * 맞바꾼다. 락이 없어서 어느 쪽도 상대를 기다리지 않고, 읽는 쪽이 느리면 중간
+ * 상태는 건너뛰고 항상 가장 최근 것만 본다. 쓰는 쪽 하나, 읽는 쪽 하나 전용. */
+struct snapshot {
+    struct game_state state;
+    unsigned long tick;         /* 만든 시뮬레이션 틱 */
+};
+
+struct snapshot_slot {
+    struct snapshot buf[3];
+    int back;                   /* 쓰는 쪽 전용 */
+    char pad1[64];
+    int front;                  /* 읽는 쪽 전용 */
+    char pad2[64];
+    int middle;                 /* 버퍼 번호 | SNAPSHOT_FRESH, 원자적으로만 접근 */
+};
+
+#define SNAPSHOT_FRESH 4        /* 가운데 버퍼를 아직 아무도 안 읽음 */
+
+void snapshot_init(struct snapshot_slot *s);
+
+/* 쓰는 쪽: 채울 버퍼. 다 채우면 snapshot_publish */
+struct snapshot *snapshot_back(struct snapshot_slot *s);
+void snapshot_publish(struct snapshot_slot *s);
+
+/* 읽는 쪽: 지난번 뒤로 새로 나온 것 중 가장 최근 것, 없으면 NULL.
+ * 돌려받은 버퍼는 다음 호출 전까지 그대로 남아 있다 */
+const struct snapshot *snapshot_latest(struct snapshot_slot *s);
+
+#endif
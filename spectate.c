@@ -0,0 +1,270 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/types.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+#include "spectate.h"
+
+#ifdef _WIN32
+
+/* 윈도우는 아직 지원 안 함 */
+int spectate_open(struct spectate_server *s, const char *path) {
+    (void)path;
+    s->fd = -1;
+    s->clients = 0;
+    s->have_last = 0;
+    return 1;
+}
+
+void spectate_publish(struct spectate_server *s, const struct game_state *g) {
+    (void)s;
+    (void)g;
+}
+
+void spectate_close(struct spectate_server *s) {
+    s->fd = -1;
+}
+
+#else
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0      /* macOS는 소켓마다 SO_NOSIGPIPE로 막는다 */
+#endif
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000 + 1;   /* 0은 "안 밀림" */
+}
+
+static int set_nonblock(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    if(flags < 0) return 1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0;
+}
+
+int spectate_open(struct spectate_server *s, const char *path) {
+    struct sockaddr_un addr;
+    struct stat st;
+
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+    if(strlen(path) >= sizeof(addr.sun_path) || strlen(path) >= sizeof(s->path)) return 1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    /* 지난번에 남은 소켓 파일만 지운다. 보통 파일이면 건드리지 않음 */
+    if(lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(path);
+
+    s->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(s->fd < 0) return 1;
+    if(set_nonblock(s->fd) != 0 ||
+       bind(s->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+       listen(s->fd, 16) != 0) {
+        close(s->fd);
+        s->fd = -1;
+        return 1;
+    }
+    strcpy(s->path, path);
+    return 0;
+}
+
+static void drop_client(struct spectate_server *s, int i) {
+    close(s->client[i]->fd);
+    free(s->client[i]);
+    s->client[i] = s->client[--s->clients];
+}
+
+static void accept_clients(struct spectate_server *s) {
+    for(;;) {
+        struct spectate_client *c;
+        int fd = accept(s->fd, NULL, NULL);
+
+        if(fd < 0) {
+            if(errno == EINTR) continue;
+            return;     /* EAGAIN: 더 기다리는 클라이언트 없음 */
+        }
+        if(s->clients == SPECTATE_MAX_CLIENTS || set_nonblock(fd) != 0 ||
+           (c = malloc(sizeof(*c))) == NULL) {
+            close(fd);
+            continue;
+        }
+#ifdef SO_NOSIGPIPE
+        {
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+        }
+#endif
+        c->fd = fd;
+        c->need_full = 1;
+        c->stalled_since = 0;
+        c->len = 0;
+        s->client[s->clients++] = c;
+    }
+}
+
+/* 버퍼에 쌓인 만큼 보낸다. 받는 쪽이 끊겼거나 너무 오래 안 읽으면 1 */
+static int flush_client(struct spectate_client *c) {
+    size_t done = 0;
+
+    while(done < c->len) {
+        ssize_t n = send(c->fd, c->buf + done, c->len - done, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if(n < 0) {
+            if(errno == EINTR) continue;
+            if(errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return 1;
+        }
+        done += (size_t)n;
+    }
+    if(done > 0) {
+        memmove(c->buf, c->buf + done, c->len - done);
+        c->len -= done;
+        c->stalled_since = 0;
+    } else if(c->stalled_since == 0) {
+        c->stalled_since = now_ms();
+    } else if(now_ms() - c->stalled_since > SPECTATE_STALL_MS) {
+        return 1;
+    }
+    return 0;
+}
+
+static void view_of(struct spectate_view *v, const struct game_state *g) {
+    memcpy(v->rows, g->tetris_table, sizeof(v->rows));
+    v->block = g->block_number;
+    v->state = g->block_state;
+    v->x = g->x;
+    v->y = g->y;
+    v->ghost_y = g->ghost_y;
+    v->next = g->next_block_number;
+    v->game = g->game;
+    v->point = g->point;
+}
+
+static unsigned char *put_le(unsigned char *p, uint64_t v, int bytes) {
+    int i;
+    for(i = 0; i < bytes; i++)
+        *p++ = (unsigned char)(v >> (8 * i));
+    return p;
+}
+
+/* prev와 달라진 부분을 메시지 하나로. prev가 NULL이면 전체 상태.
+ * 바뀐 게 없으면 0 */
+static size_t encode(unsigned char *out, const struct spectate_view *prev,
+                     const struct spectate_view *now) {
+    unsigned char *p = out + 3, *flags, *rows;
+    int i;
+
+    out[0] = prev ? SPECTATE_DELTA : SPECTATE_FULL;
+    if(!prev) {
+        *p++ = BOARD_WIDTH;
+        *p++ = BOARD_HEIGHT;
+    }
+    flags = p++;
+    *flags = 0;
+
+    rows = p++;
+    *rows = 0;
+    for(i = 0; i < BOARD_HEIGHT; i++) {
+        if(prev && prev->rows[i] == now->rows[i]) continue;
+        *p++ = (unsigned char)i;
+        p = put_le(p, (uint64_t)((now->rows[i] & FIELD_MASK) >> (1 + BOARD_SHIFT)),
+                   SPECTATE_ROW_BYTES);
+        (*rows)++;
+    }
+    if(*rows) *flags |= SPECTATE_ROWS;
+    else p = rows;
+
+    if(!prev || prev->block != now->block || prev->state != now->state ||
+       prev->x != now->x || prev->y != now->y || prev->ghost_y != now->ghost_y) {
+        *flags |= SPECTATE_PIECE;
+        *p++ = (unsigned char)now->block;
+        *p++ = (unsigned char)now->state;
+        *p++ = (unsigned char)(signed char)now->x;
+        *p++ = (unsigned char)now->y;
+        *p++ = (unsigned char)now->ghost_y;
+    }
+    if(!prev || prev->point != now->point) {
+        *flags |= SPECTATE_SCORE;
+        p = put_le(p, (uint64_t)(int64_t)now->point, 8);
+    }
+    if(!prev || prev->next != now->next || prev->game != now->game) {
+        *flags |= SPECTATE_STATUS;
+        *p++ = (unsigned char)now->next;
+        *p++ = (unsigned char)now->game;
+    }
+
+    if(prev && *flags == 0) return 0;
+    put_le(out + 1, (uint64_t)(p - out - 3), 2);
+    return (size_t)(p - out);
+}
+
+void spectate_publish(struct spectate_server *s, const struct game_state *g) {
+    unsigned char delta[SPECTATE_MAX_MSG], full[SPECTATE_MAX_MSG];
+    size_t delta_len = 0, full_len = 0;
+    struct spectate_view now;
+    int i;
+
+    if(s->fd < 0) return;
+    accept_clients(s);
+
+    view_of(&now, g);
+    if(s->clients > 0 && s->have_last)
+        delta_len = encode(delta, &s->last, &now);
+
+    for(i = s->clients - 1; i >= 0; i--) {
+        struct spectate_client *c = s->client[i];
+
+        if(c->len > 0 && flush_client(c) != 0) {
+            drop_client(s, i);
+            continue;
+        }
+
+        if(c->need_full) {
+            /* 밀린 게 다 나간 뒤에 전체 상태 하나로 따라잡기 */
+            if(c->len == 0) {
+                if(full_len == 0) full_len = encode(full, NULL, &now);
+                memcpy(c->buf, full, full_len);
+                c->len = full_len;
+                c->need_full = 0;
+            }
+        } else if(delta_len > 0) {
+            if(c->len + delta_len <= sizeof(c->buf)) {
+                memcpy(c->buf + c->len, delta, delta_len);
+                c->len += delta_len;
+            } else {
+                c->need_full = 1;   /* 버퍼가 찼다: 이후 변화는 모아서 한 번에 */
+            }
+        }
+
+        if(c->len > 0 && flush_client(c) != 0)
+            drop_client(s, i);
+    }
+
+    s->last = now;
+    s->have_last = 1;
+}
+
+void spectate_close(struct spectate_server *s) {
+    if(s->fd < 0) return;
+    while(s->clients > 0)
+        drop_client(s, s->clients - 1);
+    close(s->fd);
+    unlink(s->path);
+    s->fd = -1;
+}
+
+#endif
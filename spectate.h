@@ -0,0 +1,73 @@
+#ifndef TETRIS_SPECTATE_H
+#define TETRIS_SPECTATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "engine.h"
+
+/* 관전 서버 (--spectate PATH)
+ * 유닉스 도메인 소켓으로 관전 도구들이 붙으면, 상태가 바뀔 때마다 바뀐 부분만
+ * 메시지로 보낸다. 소켓은 전부 논블로킹이고 클라이언트마다 보낼 버퍼가 따로 있다.
+ * 느린 클라이언트는 버퍼가 차면 그 뒤 변화를 쌓지 않고 다 비운 다음 전체 상태
+ * 하나로 따라잡게 하고, 오래 못 비우면 끊는다. 게임 루프는 절대 기다리지 않는다.
+ *
+ * 메시지: 종류 1바이트, 본문 길이 2바이트(LE), 본문
+ *   SPECTATE_FULL  (처음 붙었을 때, 밀렸다 따라잡을 때)
+ *                  가로 1바이트, 세로 1바이트, 뒤는 DELTA와 같고 모든 구역이 들어 있다
+ *   SPECTATE_DELTA 구역 플래그 1바이트, 플래그가 켜진 구역만 이 순서로
+ *     SPECTATE_ROWS  줄 수 1바이트, 줄마다 행 번호 1바이트 + 굳은 칸 비트
+ *                    (벽 안쪽 첫 칸이 비트 0, SPECTATE_ROW_BYTES바이트 LE)
+ *     SPECTATE_PIECE 블록, 회전, x(부호 있음), y, 고스트 y 각 1바이트
+ *     SPECTATE_SCORE 점수 8바이트 (LE)
+ *     SPECTATE_STATUS 다음 블록, 게임 상태(GAME_START/GAME_END) 각 1바이트 */
+#define SPECTATE_FULL 1
+#define SPECTATE_DELTA 2
+
+#define SPECTATE_ROWS 0x01
+#define SPECTATE_PIECE 0x02
+#define SPECTATE_SCORE 0x04
+#define SPECTATE_STATUS 0x08
+
+#define SPECTATE_ROW_BYTES ((BOARD_WIDTH + 7) / 8)
+#define SPECTATE_MAX_MSG (7 + BOARD_HEIGHT * (1 + SPECTATE_ROW_BYTES) + 5 + 8 + 2)
+
+#define SPECTATE_MAX_CLIENTS 64
+#define SPECTATE_BUF_SIZE 8192      /* 클라이언트마다 밀려 있을 수 있는 바이트 */
+#define SPECTATE_STALL_MS 5000      /* 이만큼 한 바이트도 못 보내면 끊음 */
+
+struct spectate_client {
+    int fd;
+    int need_full;          /* 버퍼를 다 비우면 전체 상태부터 */
+    long long stalled_since;    /* 못 보내기 시작한 시각 (ms), 잘 나가고 있으면 0 */
+    size_t len;
+    unsigned char buf[SPECTATE_BUF_SIZE];
+};
+
+/* 마지막으로 내보낸 상태 */
+struct spectate_view {
+    row_t rows[BOARD_HEIGHT];
+    int block, state, x, y, ghost_y;
+    int next, game;
+    long point;
+};
+
+struct spectate_server {
+    int fd;                 /* 듣는 소켓, 꺼져 있으면 -1 */
+    char path[108];
+    struct spectate_view last;
+    int have_last;
+    int clients;
+    struct spectate_client *client[SPECTATE_MAX_CLIENTS];
+};
+
+/* path에 소켓을 만들고 듣기 시작. 실패하면 1 (s->fd는 -1로 남아 publish가 그냥 넘어감) */
+int spectate_open(struct spectate_server *s, const char *path);
+
+/* 새로 붙은 클라이언트를 받고, 바뀐 부분을 모두에게 보낸다. 막히지 않는다 */
+void spectate_publish(struct spectate_server *s, const struct game_state *g);
+
+/* 모든 연결을 닫고 소켓 파일을 지운다 */
+void spectate_close(struct spectate_server *s);
+
+#endif
@@ -1,8 +1,22 @@
+#define _DEFAULT_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
+
+#include "engine.h"
+#include "names.h"
+#include "profile.h"
+#include "records.h"
+#include "render.h"
+#include "replay.h"
+#include "selfplay.h"
+#include "snapshot.h"
+#include "spectate.h"
+#include "verify.h"
 
 // 플랫폼별 헤더 파일 포함
 #ifdef _WIN32
@@ -91,12 +105,19 @@
         SetConsoleScreenBufferSize(hOut, bufferSize);
     }
     
+    // 키 입력이 오거나 timeout_ms가 지날 때까지 대기, 입력이면 1
+    int wait_input(int timeout_ms) {
+        HANDLE hIn = GetStdHandle(STD_INPUT_HANDLE);
+        return WaitForSingleObject(hIn, (DWORD)timeout_ms) == WAIT_OBJECT_0;
+    }
+    
 #else
     #include <sys/time.h>
     #include <termios.h>
     #include <unistd.h>
     #include <sys/ioctl.h>
     #include <sys/types.h>
+    #include <poll.h>
     #define SLEEP_MS(ms) usleep((ms) * 1000)
     #define CLEAR_SCREEN() printf("\033[2J\033[H")
     
@@ -115,237 +136,73 @@
         printf("\033[2J\033[H");
         fflush(stdout);
     }
+    
+    // 키 입력이 오거나 timeout_ms가 지날 때까지 대기, 입력이면 1
+    int wait_input(int timeout_ms) {
+        struct pollfd pfd;
+        pfd.fd = STDIN_FILENO;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        return poll(&pfd, 1, timeout_ms) > 0;
+    }
 #endif
 
-/* 게임 상수 정의 */
-#define LEFT 0
-#define RIGHT 1
-#define DOWN 2
-#define ROTATE 3
-
-#define I_BLOCK 0
-#define T_BLOCK 1
-#define S_BLOCK 2
-#define Z_BLOCK 3
-#define L_BLOCK 4
-#define J_BLOCK 5
-#define O_BLOCK 6
+#define SIM_TICK_MS 10  // 시뮬레이션 시간 단위 (100Hz)
+#define CATCHUP_LIMIT_US 1000000    // 이보다 밀리면 따라잡지 않고 지금부터 다시
 
-#define GAME_START 0
-#define GAME_END 1
+/* 전역 변수 */
 
-/* 블록 정의 */
-char i_block[4][4][4] = {
-    {
-        {1, 1, 1, 1}, 
-        {0, 0, 0, 0}, 
-        {0, 0, 0, 0}, 
-        {0, 0, 0, 0}
-    },
-    {  
-        {0, 0, 0, 1}, 
-        {0, 0, 0, 1}, 
-        {0, 0, 0, 1}, 
-        {0, 0, 0, 1} 
-    },
-    {
-        {0, 0, 0, 0}, 
-        {0, 0, 0, 0}, 
-        {0, 0, 0, 0}, 
-        {1, 1, 1, 1} 
-    },
-    {
-        {1, 0, 0, 0}, 
-        {1, 0, 0, 0}, 
-        {1, 0, 0, 0}, 
-        {1, 0, 0, 0} 
-    }
-};
+struct result temp_result;
 
-char t_block[4][4][4] = {
-    {
-        {1, 0, 0, 0},   
-        {1, 1, 0, 0},   
-        {1, 0, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {1, 1, 1, 0},   
-        {0, 1, 0, 0},   
-        {0, 0, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {0, 0, 1, 0},   
-        {0, 1, 1, 0},   
-        {0, 0, 1, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {0, 0, 0, 0},   
-        {0, 1, 0, 0},   
-        {1, 1, 1, 0},   
-        {0, 0, 0, 0}
-    }
-};
+struct game_state current_game;
+struct renderer screen;
+int best_point = 0;
 
-char s_block[4][4][4] = {
-    {
-        {1, 0, 0, 0},   
-        {1, 1, 0, 0},   
-        {0, 1, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {0, 1, 1, 0},   
-        {1, 1, 0, 0},   
-        {0, 0, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {1, 0, 0, 0},   
-        {1, 1, 0, 0},   
-        {0, 1, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {0, 1, 1, 0},   
-        {1, 1, 0, 0},   
-        {0, 0, 0, 0},   
-        {0, 0, 0, 0}
-    }
-};
+/* 블록 순서 설정 (--seed, --bag) */
+int seed_given = 0;
+uint64_t game_seed = 0;
+int randomizer = RANDOMIZER_UNIFORM;
 
-char z_block[4][4][4] = {
-    {
-        {0, 1, 0, 0},   
-        {1, 1, 0, 0},   
-        {1, 0, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {1, 1, 0, 0},   
-        {0, 1, 1, 0},   
-        {0, 0, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {0, 1, 0, 0},   
-        {1, 1, 0, 0},   
-        {1, 0, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {1, 1, 0, 0},   
-        {0, 1, 1, 0},   
-        {0, 0, 0, 0},   
-        {0, 0, 0, 0}
-    }
-};
+// --seed가 없을 때 쓸 시드. 같은 초에 시작한 게임끼리도 겹치지 않게
+// 벽시계, 단조 시계, pid를 splitmix64로 차례로 섞는다
+uint64_t pick_seed(void) {
+    uint64_t state = (uint64_t)time(NULL);
+    uint64_t seed = rng_next(&state);
+#ifdef _WIN32
+    uint64_t pid = (uint64_t)GetCurrentProcessId();
+#else
+    uint64_t pid = (uint64_t)getpid();
+#endif
+    
+    state ^= (uint64_t)profile_now_us();
+    seed ^= rng_next(&state);
+    state ^= pid;
+    seed ^= rng_next(&state);
+    return seed;
+}
 
-char l_block[4][4][4] = {
-    {
-        {1, 0, 0, 0},   
-        {1, 0, 0, 0},   
-        {1, 1, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {1, 1, 1, 0},   
-        {1, 0, 0, 0},   
-        {0, 0, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {0, 1, 1, 0},   
-        {0, 0, 1, 0},   
-        {0, 0, 1, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {0, 0, 0, 0},   
-        {0, 0, 1, 0},   
-        {1, 1, 1, 0},   
-        {0, 0, 0, 0}
-    }
+/* 프레임 시간 측정 (--profile, TETRIS_PROFILE). 시뮬레이션과 렌더 스레드 따로 */
+int profile_enabled = 0;
+struct profile frame_profile;
+struct profile render_profile;
+
+/* 시뮬레이션 스레드 -> 렌더 스레드
+ * 상태는 락 없는 slot으로 넘기고, 깨우는 것만 조건 변수로 한다.
+ * 렌더 스레드는 새 스냅샷이나 끝 신호가 올 때까지 잔다 */
+struct render_link {
+    struct snapshot_slot slot;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int pending;            /* 아직 안 본 스냅샷이 있음, lock 아래에서만 */
+    int done;               /* 마지막 스냅샷을 냈음, lock 아래에서만 */
 };
-
-char j_block[4][4][4] = {
-    {
-        {0, 1, 0, 0},  
-        {0, 1, 0, 0},  
-        {1, 1, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {1, 0, 0, 0},   
-        {1, 1, 1, 0},   
-        {0, 0, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {0, 1, 1, 0},   
-        {0, 1, 0, 0},   
-        {0, 1, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {0, 0, 0, 0},   
-        {1, 1, 1, 0},   //회전이 이상하게 되어있음 
-        {0, 0, 1, 0},   
-        {0, 0, 0, 0}
-    }
+struct render_link render_link = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER
 };
 
-char o_block[4][4][4] = {
-    {
-        {1, 1, 0, 0},   
-        {1, 1, 0, 0},   
-        {0, 0, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {1, 1, 0, 0},   
-        {1, 1, 0, 0},   
-        {0, 0, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {1, 1, 0, 0},   
-        {1, 1, 0, 0},   // 네모가 갑자기 자식을 낳음
-        {0, 0, 0, 0},   
-        {0, 0, 0, 0}
-    },
-    {
-        {1, 1, 0, 0},   
-        {1, 1, 0, 0},   
-        {0, 0, 0, 0},   
-        {0, 0, 0, 0}
-    }
-};
-
-/* 전역 변수 */
-char tetris_table[21][10];
-
-struct result {
-    char name[30];
-    long point;
-    int year;
-    int month;
-    int day;
-    int hour;
-    int min;
-    int rank;
-} temp_result;
-
-int block_number = 0;
-int next_block_number = 0;
-int block_state = 0;
-int x = 3, y = 0;
-int game = GAME_END;
-int best_point = 0;
-long point = 0;
-int ghost_y = 0;
+/* 관전 서버 (--spectate PATH) */
+struct spectate_server spectator = { .fd = -1 };
 
 // 플랫폼별 키보드 입력 처리 
 #ifdef _WIN32
@@ -482,98 +339,13 @@ void Player_name(char* name, int max_len) {
 
 /* 함수 프로토타입 선언 */
 int print_menu(void);
-int init_tetris_table(void);
-int print_tetris_sc(void);
+int print_tetris_sc(const struct game_state *g);
 int game_start(void);
-int refresh(int);
-int move_block(int);
-int drop(void);
-int collision_test(int);
-int check_one_line(void);
 int print_result(void);
 int search_result(void);
-void calculate_ghost_position(void);
-void ghost_rf(int);
-
-/* 고스트 블록 위치 계산 */
-void calculate_ghost_position(void) {
-    int original_y = y;
-    
-    ghost_y = y;
-    while (1) {
-        y = ghost_y + 1;
-        
-        if (collision_test(DOWN) == 1) {
-            ghost_y = y - 1;
-            break;
-        }
-        ghost_y++;
-    }
-    
-    y = original_y;
-}
-
-//고스트 블록을 포함한 화면 새로고침
-void ghost_rf(int block) {
-    int i, j;
-    int block_array_x, block_array_y;
-    char (*block_pointer)[4][4] = NULL;
-    
-    // 먼저 움직이는 블록 지우기
-    for(i = 0; i < 20; i++) {
-        for(j = 1; j < 9; j++) {
-            if(tetris_table[i][j] == 2 || tetris_table[i][j] == 3) {
-                tetris_table[i][j] = 0;
-            }
-        }
-    }
-    
-    switch(block) {
-        case I_BLOCK: block_pointer = i_block; break;
-        case T_BLOCK: block_pointer = t_block; break;
-        case S_BLOCK: block_pointer = s_block; break;
-        case Z_BLOCK: block_pointer = z_block; break;
-        case L_BLOCK: block_pointer = l_block; break;
-        case J_BLOCK: block_pointer = j_block; break;
-        case O_BLOCK: block_pointer = o_block; break;
-        default: return;
-    }
-    
-    // 고스트 블록 위치 계산
-    calculate_ghost_position();
-    
-    /* 고스트 블록 그리기 */
-    if (ghost_y != y) {  /* 현재 블록과 다른 위치에만 고스트 표시 */
-        for(i = 0; i < 4; i++) {
-            for(j = 0; j < 4; j++) {
-                block_array_x = j + x;
-                block_array_y = i + ghost_y;
-                
-                if(block_pointer[block_state][i][j] == 1) {
-                    if (block_array_y >= 0 && block_array_y < 20 && 
-                        block_array_x > 0 && block_array_x < 9) {
-                        tetris_table[block_array_y][block_array_x] = 3;
-                    }
-                }
-            }
-        }
-    }
-    
-    /* 현재 블록 그리기 */
-    for(i = 0; i < 4; i++) {
-        for(j = 0; j < 4; j++) {
-            block_array_x = j + x;
-            block_array_y = i + y;
-            
-            if(block_pointer[block_state][i][j] == 1) {
-                if (block_array_y >= 0 && block_array_y < 20 && 
-                    block_array_x > 0 && block_array_x < 9) {
-                    tetris_table[block_array_y][block_array_x] = 2;
-                }
-            }
-        }
-    }
-}
+const char *format_played(int64_t played, char *buf, size_t size);
+int print_player_stats(void);
+void print_usage(const char *prog);
 
 int print_menu(void) {
     int menu = 0;
@@ -604,185 +376,213 @@ int print_menu(void) {
     return 0;
 }
 
-int init_tetris_table(void) {
-    int i, j;
-    for(i = 0; i < 20; i++)
-        for(j = 0; j < 10; j++)
-            tetris_table[i][j] = 0;
-    for(i = 0; i < 21; i++) {
-        tetris_table[i][0] = 1;
-        tetris_table[i][9] = 1;
-    }
-    for(j = 1; j < 9; j++)
-        tetris_table[20][j] = 1;
+// 직전 프레임과 달라진 칸만 모아서 한 번에 출력
+int print_tetris_sc(const struct game_state *g) {
+    if(render_frame(&screen, g, best_point) > 0)
+        render_flush(&screen);
+    
     return 0;
 }
 
-int print_tetris_sc(void) {
-    int i, j;
-    char (*block_pointer)[4][4] = NULL;
-    
-    switch(next_block_number) {
-        case I_BLOCK: block_pointer = i_block; break;
-        case T_BLOCK: block_pointer = t_block; break;
-        case S_BLOCK: block_pointer = s_block; break;
-        case Z_BLOCK: block_pointer = z_block; break;
-        case L_BLOCK: block_pointer = l_block; break;
-        case J_BLOCK: block_pointer = j_block; break;
-        case O_BLOCK: block_pointer = o_block; break;
-        default: return 1;
+// 키 하나를 명령으로, 해당 없으면 -1
+int key_command(int key) {
+    switch(key) {
+        case 'j':
+        case 'J':
+            return LEFT;
+        case 'l':
+        case 'L':
+            return RIGHT;
+        case 'k':
+        case 'K':
+            return DOWN;
+        case 'i':
+        case 'I':
+            return ROTATE;
+        case 'a':
+        case 'A':
+            return HARD_DROP;
+        case 'p':
+        case 'P':
+            return QUIT;
+        default:
+            return -1;
     }
-    
-    update_game_screen();
+}
 
-    printf("<< TETRIS >>\n\n");
-    printf("Next Block\n");
+// 렌더 스레드: 새 스냅샷이 있을 때마다 가장 최근 것만 그린다.
+// 터미널 쓰기가 느려도 시뮬레이션은 기다리지 않고, 그 사이 상태는 건너뛴다
+void *render_main(void *arg) {
+    struct render_link *link = arg;
     
-    for(i = 0; i < 4; i++) {
-        printf("    ");
-        for(j = 0; j < 4; j++) {
-            if(block_pointer[0][i][j] == 1)
-#ifdef _WIN32
-                printf("[]");
-#else
-                printf("🟥");
-#endif
-            else
-                printf("  ");
-        }
-        printf("\n");
-    }
-    
-    printf("\n");
-    for(i = 0; i < 21; i++){
-        printf("    ");
-        for(j = 0; j < 10; j++){
-            if(j == 0 || j == 9 || i == 20)
-#ifdef _WIN32
-                printf("||");
-#else
-                printf("⬜");
-#endif
-            else{
-                if(tetris_table[i][j] == 1)
-#ifdef _WIN32
-                    printf("[]");
-#else
-                    printf("🟩");
-#endif
-                else if(tetris_table[i][j] == 2)
-#ifdef _WIN32
-                    printf("##");
-#else
-                    printf("🟥");
-#endif
-                else if(tetris_table[i][j] == 3)
-#ifdef _WIN32
-                    printf("--");
-#else
-                    printf("⬛");
-#endif
-                else
-                    printf("  ");
-            }
+    profile_start(&render_profile, profile_enabled, FRAME_BUDGET_US);
+    for(;;) {
+        const struct snapshot *snap;
+        int done;
+        
+        pthread_mutex_lock(&link->lock);
+        while(!link->pending && !link->done)
+            pthread_cond_wait(&link->wake, &link->lock);
+        link->pending = 0;
+        done = link->done;
+        pthread_mutex_unlock(&link->lock);
+        
+        // 그리는 동안 여러 번 publish됐으면 가장 최근 것 하나만
+        snap = snapshot_latest(&link->slot);
+        if(snap == NULL) {
+            if(done) break;
+            continue;
         }
-        printf("\n");
+        profile_mark(&render_profile, PHASE_WAIT);
+        print_tetris_sc(&snap->state);
+        profile_mark(&render_profile, PHASE_RENDER);
+        spectate_publish(&spectator, &snap->state);
+        profile_end_frame(&render_profile);
     }
+    return NULL;
+}
+
+// 현재 상태를 렌더 스레드에 넘긴다. 스레드가 없으면 바로 그림
+void publish_state(const struct game_state *g, unsigned long tick, int threaded) {
+    struct snapshot *snap;
     
-    printf("\nCurrent Score: %ld\n", point);
-    printf("Best Score: %d\n", best_point);
-    printf("\nControls: J(left) L(right) K(down) I(rotate) A(drop) P(quit)\n");
-    printf("Ghost block shows where your piece will land\n");
-    
-    for(i = 0; i < 3; i++) {
-        printf("                                                                                \n");
+    if(!threaded) {
+        print_tetris_sc(g);
+        spectate_publish(&spectator, g);
+        return;
     }
+    snap = snapshot_back(&render_link.slot);
+    snap->state = *g;
+    snap->tick = tick;
+    snapshot_publish(&render_link.slot);
     
-    return 0;
+    pthread_mutex_lock(&render_link.lock);
+    render_link.pending = 1;
+    pthread_cond_signal(&render_link.wake);
+    pthread_mutex_unlock(&render_link.lock);
 }
 
 int game_start(void) {
-    int key;
-    long frame_count = 0;
-    int drop_interval = 30;
-    
-    init_tetris_table();
-    srand(time(NULL));
-    
-    block_number = rand() % 7;
-    next_block_number = rand() % 7;
-    
-    game = GAME_START;
-    point = 0;
-    x = 3;
-    y = 0;
-    block_state = 0;
+    struct game_state *g = &current_game;
+    struct replay_writer replay;
+    uint64_t seed = seed_given ? game_seed : pick_seed();
+    int key, command;
+    long gravity_ticks = 0;
+    unsigned long tick = 0, piece;
+    long long start, gravity_deadline;
+    pthread_t renderer;
+    int threaded;
+    
+    game_init(g, seed, randomizer);
+    g->leveling = 1;
+    replay_open(&replay, seed, randomizer, g->leveling);
     
     init_keyboard();
     setup_console_buffer();
     CLEAR_SCREEN();
     hide_cursor();
     
-    ghost_rf(block_number);
-    print_tetris_sc();
-    
-    while(game == GAME_START) {
-        key = getch_nonb();
-
-        if(key != EOF) {
-            switch(key) {
-                case 'j':
-                case 'J':
-                    move_block(LEFT);
-                    break;
-                case 'l':
-                case 'L':
-                    move_block(RIGHT);
-                    break;
-                case 'k':
-                case 'K':
-                    move_block(DOWN);
-                    break;
-                case 'i':
-                case 'I':
-                    move_block(ROTATE);
-                    break;
-                case 'a':
-                case 'A':
-                    drop();
-                    break;
-                case 'p':
-                case 'P':
-                    game = GAME_END;
-                    break;
-                default:
-                    break;
+    render_reset(&screen);
+    ghost_rf(g);
+    
+    // 화면은 렌더 스레드가 맡는다. 못 만들면 예전처럼 한 스레드에서 그림
+    snapshot_init(&render_link.slot);
+    render_link.pending = 0;
+    render_link.done = 0;
+    threaded = pthread_create(&renderer, NULL, render_main, &render_link) == 0;
+    publish_state(g, tick, threaded);
+    
+    // 시간은 SIM_TICK_MS 단위 틱으로 센다 (스냅샷의 tick). 틱마다 깨지는 않고
+    // 입력이 오거나 중력 마감이 될 때만 일어나서, 가만히 있으면 중력 간격마다 한 번 깬다.
+    // 중력은 절대 마감 시각이라 늦게 깨면 놓친 만큼 한꺼번에 내려서 레벨 속도가
+    // 프레임 비용과 상관없다. 새 블록은 나온 시각부터 한 간격을 온전히 받는다
+    // (레벨이 바뀌었으면 새 간격)
+    profile_start(&frame_profile, profile_enabled, SIM_TICK_MS * 1000);
+    start = profile_now_us();
+    piece = g->pieces;
+    gravity_deadline = start + gravity_interval_us(g);
+    while(g->game == GAME_START) {
+        long long now = profile_now_us();
+        int changed = 0;
+        
+        // 올림해서 기다려야 마감 직전에 깨서 헛도는 일이 없다
+        if(now < gravity_deadline)
+            wait_input((int)((gravity_deadline - now + 999) / 1000));
+        profile_mark(&frame_profile, PHASE_WAIT);
+
+        // 쌓인 입력은 한 번에 다 처리
+        while(g->game == GAME_START && (key = getch_nonb()) != EOF) {
+            command = key_command(key);
+            if(command >= 0) {
+                // 리플레이에는 몇 번째 중력 틱 뒤의 입력인지 함께 기록
+                replay_event(&replay, gravity_ticks, command);
+                game_command(g, command);
+                changed = 1;
             }
         }
-
-        frame_count++;
-        if (frame_count % drop_interval == 0) {
-            move_block(DOWN);
+        now = profile_now_us();
+        if(g->pieces != piece) {
+            piece = g->pieces;
+            gravity_deadline = now + gravity_interval_us(g);
+        }
+        profile_mark(&frame_profile, PHASE_INPUT);
+
+        // 한참 밀렸으면 (일시정지 등) 따라잡지 않고 지금부터 다시
+        if(gravity_deadline + CATCHUP_LIMIT_US <= now)
+            gravity_deadline = now;
+        while(g->game == GAME_START && gravity_deadline <= now) {
+            gravity_ticks++;
+            changed = 1;
+            if(gravity_step(g) == 1) {
+                // 굳었으면 따라잡기는 여기까지. 밀린 시간을 다음 블록에 넘기지 않는다
+                piece = g->pieces;
+                gravity_deadline = now + gravity_interval_us(g);
+                break;
+            }
+            gravity_deadline += gravity_interval_us(g);
         }
+        profile_mark(&frame_profile, PHASE_GRAVITY);
 
-        ghost_rf(block_number);
-        print_tetris_sc();
-
-        SLEEP_MS(33);  // 프레임 레이트를 30fps로 개선 (33ms)
+        // 바뀐 게 없으면 (모르는 키) 그리지 않는다
+        if(changed) {
+            tick = (unsigned long)((now - start) / (SIM_TICK_MS * 1000));
+            ghost_rf(g);
+            profile_mark(&frame_profile, PHASE_GHOST);
+            publish_state(g, tick, threaded);
+            if(!threaded) profile_mark(&frame_profile, PHASE_RENDER);
+        }
+        profile_end_frame(&frame_profile);
+    }
+    
+    if(threaded) {
+        pthread_mutex_lock(&render_link.lock);
+        render_link.done = 1;
+        pthread_cond_signal(&render_link.wake);
+        pthread_mutex_unlock(&render_link.lock);
+        pthread_join(renderer, NULL);
     }
     
+    replay_close(&replay, gravity_ticks, g->point);
+    
     show_cursor();
     reset_keyboard();
 
     CLEAR_SCREEN();
     printf("\n\n\t\t\tGAME OVER!\n");
-    printf("\n\t\t\tYour Score: %ld\n", point);
+    printf("\n\t\t\tYour Score: %ld\n", g->point);
     
-    if(point > best_point) {
-        best_point = point;
+    if(g->point > best_point) {
+        best_point = g->point;
         printf("\n\t\t\tNEW BEST SCORE!\n");
     }
     
+    if(profile_enabled) {
+        printf("\nSimulation thread\n");
+        profile_report(&frame_profile, stdout);
+        printf("\nRender thread\n");
+        profile_report(&render_profile, stdout);
+    }
+    
     printf("\n\t\t\tPress Enter to save score...\n");
     
 #ifdef _WIN32
@@ -793,7 +593,7 @@ int game_start(void) {
     getchar();
 #endif
     
-    temp_result.point = point;
+    temp_result.point = g->point;
     time_t t = time(NULL);
     struct tm *tm = localtime(&t);
     temp_result.year = tm->tm_year + 1900;
@@ -804,11 +604,9 @@ int game_start(void) {
     
     Player_name(temp_result.name, sizeof(temp_result.name));
     
-    FILE *fp = fopen("tetris_result.dat", "ab");
-    if(fp != NULL) {
-        fwrite(&temp_result, sizeof(struct result), 1, fp);
-        fclose(fp);
+    if(records_append(&temp_result, NULL) == 0) {
         printf("\n\t\t\tScore saved successfully!\n");
+        printf("\t\t\tYour rank: %ld / %ld\n", score_rank(temp_result.point), records_count());
     } else {
         printf("\n\t\t\tFailed to save score!\n");
     }
@@ -819,235 +617,21 @@ int game_start(void) {
     return 1;
 }
 
-int refresh(int block) {
-    int i, j;
-    int block_array_x, block_array_y;
-    char (*block_pointer)[4][4] = NULL;
-    
-    for(i = 0; i < 20; i++) {
-        for(j = 1; j < 9; j++) {
-            if(tetris_table[i][j] == 2)
-                tetris_table[i][j] = 0;
-        }
-    }
-    
-    switch(block) {
-        case I_BLOCK: block_pointer = i_block; break;
-        case T_BLOCK: block_pointer = t_block; break;
-        case S_BLOCK: block_pointer = s_block; break;
-        case Z_BLOCK: block_pointer = z_block; break;
-        case L_BLOCK: block_pointer = l_block; break;
-        case J_BLOCK: block_pointer = j_block; break;
-        case O_BLOCK: block_pointer = o_block; break;
-        default: return 1;
-    }
-    
-    for(i = 0; i < 4; i++) {
-        for(j = 0; j < 4; j++) {
-            block_array_x = j + x;
-            block_array_y = i + y;
-            
-            if(block_pointer[block_state][i][j] == 1) {
-                if (block_array_y >= 0 && block_array_y < 20 && 
-                    block_array_x > 0 && block_array_x < 9) {
-                    tetris_table[block_array_y][block_array_x] = 2;
-                }
-            }
-        }
-    }
-    
-    return 0;
-}
-
-int move_block(int command) {
-    int old_x = x;
-    int old_y = y;
-    int old_block_state = block_state;
-    
-    switch(command) {
-        case LEFT:
-            x--;
-            break;
-        case RIGHT:
-            x++;
-            break;
-        case DOWN:
-            y++;
-            break;
-        case ROTATE:
-            block_state = (block_state + 1) % 4;
-            break;
-    }
-    
-    if(collision_test(command) == 1) {
-        x = old_x;
-        y = old_y;
-        block_state = old_block_state;
-        
-        if(command == DOWN) {
-            int i, j;
-            char (*block_pointer)[4][4] = NULL;
-            
-            switch(block_number) {
-                case I_BLOCK: block_pointer = i_block; break;
-                case T_BLOCK: block_pointer = t_block; break;
-                case S_BLOCK: block_pointer = s_block; break;
-                case Z_BLOCK: block_pointer = z_block; break;
-                case L_BLOCK: block_pointer = l_block; break;
-                case J_BLOCK: block_pointer = j_block; break;
-                case O_BLOCK: block_pointer = o_block; break;
-                default: return 1;
-            }
-            
-            for(i = 0; i < 4; i++) {
-                for(j = 0; j < 4; j++) {
-                    if(block_pointer[old_block_state][i][j] == 1) {
-                        if(i + old_y >= 0 && i + old_y < 20 && 
-                           j + old_x > 0 && j + old_x < 9)
-                            tetris_table[i + old_y][j + old_x] = 1;
-                    }
-                }
-            }
-            
-            check_one_line();
-            
-            block_number = next_block_number;
-            next_block_number = rand() % 7;
-            block_state = 0;
-            x = 3;
-            y = 0;
-            
-            if(collision_test(DOWN) == 1) {
-                game = GAME_END;
-            }
-        }
-        
-        return 1;
-    }
-    
-    return 0;
-}
-
-int drop(void) {
-    while(collision_test(DOWN) == 0) {
-        y++;
-    }
-    
-    y--;
-    move_block(DOWN);
-    
-    return 0;
-}
-
-int collision_test(int command) {
-    (void)command;
-
-    int i, j;
-    int test_x = x;
-    int test_y = y;
-    int test_block_state = block_state;
-    char (*block_pointer)[4][4] = NULL;
-    
-    switch(block_number) {
-        case I_BLOCK: block_pointer = i_block; break;
-        case T_BLOCK: block_pointer = t_block; break;
-        case S_BLOCK: block_pointer = s_block; break;
-        case Z_BLOCK: block_pointer = z_block; break;
-        case L_BLOCK: block_pointer = l_block; break;
-        case J_BLOCK: block_pointer = j_block; break;
-        case O_BLOCK: block_pointer = o_block; break;
-        default: return 1;
-    }
-    
-    for(i = 0; i < 4; i++) {
-        for(j = 0; j < 4; j++) {
-            if(block_pointer[test_block_state][i][j] == 1) {
-                int block_array_x = j + test_x;
-                int block_array_y = i + test_y;
-                
-                if(block_array_x < 1 || block_array_x > 8) return 1;
-                if(block_array_y > 19) return 1;
-                
-                if (block_array_y >= 0 && tetris_table[block_array_y][block_array_x] == 1) {
-                    return 1;
-                }
-            }
-        }
-    }
-    
-    return 0;
-}
-
-int check_one_line(void) {
-    int i, j, k;
-    int line_count = 0;
-    
-    for(i = 19; i >= 0; i--) {
-        int line_flag = 1;
-        
-        for(j = 1; j < 9; j++) {
-            if(tetris_table[i][j] == 0) {
-                line_flag = 0;
-                break;
-            }
-        }
-        
-        if(line_flag) {
-            for(k = i; k > 0; k--) {
-                for(j = 1; j < 9; j++) {
-                    tetris_table[k][j] = tetris_table[k-1][j];
-                }
-            }
-            
-            for(j = 1; j < 9; j++) {
-                tetris_table[0][j] = 0;
-            }
-            
-            line_count++;
-            i++;
-        }
-    }
-    
-    if(line_count == 1)
-        point += 100;
-    else if(line_count == 2)
-        point += 300;
-    else if(line_count == 3)
-        point += 600;
-    else if(line_count == 4)
-        point += 1000;
-    
-    return line_count;
-}
-
 int print_result(void) {
-    FILE *fp;
-    struct result *result_pointer;
-    int count = 0;
-    int i, j;
+    struct record_view view;
+    struct result r;
+    long top[10];
+    int count = 0, rank = 0;
+    int i;
     
-    fp = fopen("tetris_result.dat", "rb");
-    if(fp == NULL) {
-        printf("\n\t\t\tNo records found!\n");
-        printf("\n\t\t\tPress any key to continue...\n");
-        flush_input_buffer();
-#ifdef _WIN32
-        _getch();
-#else
-        while(getch_nonb() == EOF) {
-            SLEEP_MS(10);
-        }
-#endif
-        return 1;
+    // 색인이 기록 파일보다 뒤처져 있으면 먼저 맞춘 뒤 앞쪽 10개만 본다
+    if(records_open_view(&view) == 0 && view.count > 0) {
+        score_index_update();
+        count = (int)score_index_top(10, top);
     }
     
-    fseek(fp, 0, SEEK_END);
-    long file_size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-    
-    count = (int)(file_size / sizeof(struct result));
-    
     if(count == 0) {
+        records_close_view(&view);
         printf("\n\t\t\tNo records found!\n");
         printf("\n\t\t\tPress any key to continue...\n");
         flush_input_buffer();
@@ -1058,51 +642,29 @@ int print_result(void) {
             SLEEP_MS(10);
         }
 #endif
-        fclose(fp);
-        return 1;
-    }
-    
-    result_pointer = (struct result*)malloc(sizeof(struct result) * count);
-    if(result_pointer == NULL) {
-        printf("\n\t\t\tMemory allocation failed!\n");
-        fclose(fp);
         return 1;
     }
     
-    fread(result_pointer, sizeof(struct result), count, fp);
-    fclose(fp);
-    
-    struct result temp;
-    for(i = 0; i < count - 1; i++) {
-        for(j = 0; j < count - i - 1; j++) {
-            if(result_pointer[j].point < result_pointer[j+1].point) {
-                temp = result_pointer[j];
-                result_pointer[j] = result_pointer[j+1];
-                result_pointer[j+1] = temp;
-            }
-        }
-    }
-    
-    for(i = 0; i < count; i++) {
-        result_pointer[i].rank = i + 1;
-    }
-    
     CLEAR_SCREEN();
     printf("\n\t\t\t\tTETRIS RANKING\n");
     printf("\t\t\t================================\n");
     printf("\t\tRank\tName\t\tScore\t\tDate\n");
     printf("\t\t\t================================\n");
     
-    for(i = 0; i < count && i < 10; i++) {
+    for(i = 0; i < count; i++) {
+        // 색인을 맞춘 뒤에 저장된 기록은 매핑에 없을 수 있다. 체크섬이 틀리면 건너뜀
+        if(top[i] >= view.count || !record_valid(&view.records[top[i]])) continue;
+        record_decode(&view.records[top[i]], &r);
+        // 건너뛴 기록이 있어도 순위는 실제로 보여준 줄 기준
         printf("\t\t%d\t%-10s\t%ld\t\t%d-%02d-%02d %02d:%02d\n",
-            result_pointer[i].rank,
-            result_pointer[i].name,
-            result_pointer[i].point,
-            result_pointer[i].year,
-            result_pointer[i].month,
-            result_pointer[i].day,
-            result_pointer[i].hour,
-            result_pointer[i].min);
+            ++rank,
+            r.name,
+            r.point,
+            r.year,
+            r.month,
+            r.day,
+            r.hour,
+            r.min);
     }
     
     printf("\t\t\t================================\n");
@@ -1116,16 +678,18 @@ int print_result(void) {
     }
 #endif
     
-    free(result_pointer);
+    records_close_view(&view);
     return 1;
 }
 
 int search_result(void) {
-    FILE *fp;
-    struct result *result_pointer;
+    struct record_view view;
+    struct player_entry stats;
+    struct result r;
     char search_name[30];
-    int count = 0;
-    int i;
+    char played[20];
+    long *records;
+    long count, i;
     int found = 0;
     
     CLEAR_SCREEN();
@@ -1133,7 +697,7 @@ int search_result(void) {
     printf("\t\t\t====================\n");
     
 #ifdef _WIN32
-    printf("\n\t\t\tEnter name to search: ");
+    printf("\n\t\t\tEnter name to search (name* for prefix): ");
     fflush(stdout);
     
     int i_input = 0;
@@ -1175,7 +739,7 @@ int search_result(void) {
         usleep(100000);  // 0.1초 대기
     #endif
     
-    printf("\n\t\t\tEnter name to search: ");
+    printf("\n\t\t\tEnter name to search (name* for prefix): ");
     fflush(stdout);
     
     // 입력 버퍼 비우기
@@ -1189,28 +753,8 @@ int search_result(void) {
     tcsetattr(STDIN_FILENO, TCSANOW, &old_tty);
 #endif
     
-    fp = fopen("tetris_result.dat", "rb");
-    if(fp == NULL) {
-        printf("\n\t\t\tNo records found!\n");
-        printf("\n\t\t\tPress any key to continue...\n");
-        flush_input_buffer();
-#ifdef _WIN32
-        _getch();
-#else
-        while(getch_nonb() == EOF) {
-            SLEEP_MS(10);
-        }
-#endif
-        return 1;
-    }
-    
-    fseek(fp, 0, SEEK_END);
-    long file_size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-    
-    count = (int)(file_size / sizeof(struct result));
-    
-    if(count == 0) {
+    if(records_open_view(&view) != 0 || view.count == 0) {
+        records_close_view(&view);
         printf("\n\t\t\tNo records found!\n");
         printf("\n\t\t\tPress any key to continue...\n");
         flush_input_buffer();
@@ -1221,38 +765,41 @@ int search_result(void) {
             SLEEP_MS(10);
         }
 #endif
-        fclose(fp);
         return 1;
     }
     
-    result_pointer = (struct result*)malloc(sizeof(struct result) * count);
-    if(result_pointer == NULL) {
-        printf("\n\t\t\tMemory allocation failed!\n");
-        fclose(fp);
-        return 1;
-    }
-    
-    fread(result_pointer, sizeof(struct result), count, fp);
-    fclose(fp);
-    
     printf("\n\t\t\tSearch Results for: %s\n", search_name);
     printf("\t\t\t================================\n");
     
-    for(i = 0; i < count; i++) {
-        if(strcmp(result_pointer[i].name, search_name) == 0) {
-            printf("\t\tName: %s\n", result_pointer[i].name);
-            printf("\t\tScore: %ld\n", result_pointer[i].point);
-            printf("\t\tDate: %d-%02d-%02d %02d:%02d\n",
-                result_pointer[i].year,
-                result_pointer[i].month,
-                result_pointer[i].day,
-                result_pointer[i].hour,
-                result_pointer[i].min);
-            printf("\t\t--------------------------------\n");
-            found = 1;
-        }
+    // 정확한 이름이면 저장해 둔 합계부터 보여 준다
+    if(name_player(search_name, &stats) == 0) {
+        printf("\t\tGames: %lu  Best: %ld  Mean: %.1f  Median: %ld\n",
+            (unsigned long)stats.games,
+            (long)stats.best,
+            (double)stats.total / stats.games,
+            (long)stats.median);
+        printf("\t\tLast played: %s\n", format_played(stats.last_played, played, sizeof(played)));
+        printf("\t\t================================\n");
     }
     
+    // 이름 색인으로 그 플레이어의 기록만 바로 찾는다. 끝에 *를 붙이면 앞부분 검색
+    count = name_search(search_name, &records);
+    for(i = 0; i < count; i++) {
+        if(records[i] >= view.count || !record_valid(&view.records[records[i]])) continue;
+        record_decode(&view.records[records[i]], &r);
+        printf("\t\tName: %s\n", r.name);
+        printf("\t\tScore: %ld\n", r.point);
+        printf("\t\tDate: %d-%02d-%02d %02d:%02d\n",
+            r.year,
+            r.month,
+            r.day,
+            r.hour,
+            r.min);
+        printf("\t\t--------------------------------\n");
+        found = 1;
+    }
+    free(records);
+    
     if(!found) {
         printf("\t\tNo records found for '%s'\n", search_name);
     }
@@ -1266,12 +813,135 @@ int search_result(void) {
     }
 #endif
     
-    free(result_pointer);
+    records_close_view(&view);
     return 1;
 }
 
-int main(void) {
+// YYYYMMDDHHMM -> "YYYY-MM-DD HH:MM"
+const char *format_played(int64_t played, char *buf, size_t size) {
+    snprintf(buf, size, "%d-%02d-%02d %02d:%02d",
+        (int)(played / 100000000),
+        (int)(played / 1000000 % 100),
+        (int)(played / 10000 % 100),
+        (int)(played / 100 % 100),
+        (int)(played % 100));
+    return buf;
+}
+
+// 플레이어별 합계를 CSV로. 플레이어 표만 읽으므로 기록 수와 상관없다
+int print_player_stats(void) {
+    struct player_entry *players;
+    char played[20];
+    long count, i;
+    
+    count = name_players(&players);
+    if(count < 0) {
+        fprintf(stderr, "No records found!\n");
+        return 1;
+    }
+    
+    printf("name,games,best,mean,median,last_played\n");
+    for(i = 0; i < count; i++) {
+        const char *c;
+        
+        if(players[i].games == 0) continue;
+        // 이름은 따옴표로 감싸고 안의 따옴표는 두 번
+        putchar('"');
+        for(c = players[i].name; *c != '\0' && c < players[i].name + sizeof(players[i].name); c++) {
+            if(*c == '"') putchar('"');
+            putchar(*c);
+        }
+        putchar('"');
+        printf(",%lu,%ld,%.1f,%ld,%s\n",
+            (unsigned long)players[i].games,
+            (long)players[i].best,
+            (double)players[i].total / players[i].games,
+            (long)players[i].median,
+            format_played(players[i].last_played, played, sizeof(played)));
+    }
+    free(players);
+    
+    return 0;
+}
+
+void print_usage(const char *prog) {
+    printf("Usage: %s [--selfplay N] [--verify REPLAY...] [--threads T] [--seed S] [--bag] [--migrate] [--stats] [--profile] [--spectate SOCKET]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
     int menu = 1;
+    long selfplay_games = 0;
+    int threads = 0;
+    int verify_first = 0, verify_count = 0;
+    int migrate_only = 0;
+    int stats_only = 0;
+    const char *profile_env;
+    const char *spectate_path = NULL;
+    long migrated;
+    int i;
+    
+    // 명령행 옵션: 헤드리스 모드
+    for(i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--selfplay") == 0 && i + 1 < argc) {
+            selfplay_games = atol(argv[++i]);
+        } else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            game_seed = strtoull(argv[++i], NULL, 10);
+            seed_given = 1;
+        } else if(strcmp(argv[i], "--bag") == 0) {
+            randomizer = RANDOMIZER_BAG;
+        } else if(strcmp(argv[i], "--migrate") == 0) {
+            migrate_only = 1;
+        } else if(strcmp(argv[i], "--stats") == 0) {
+            stats_only = 1;
+        } else if(strcmp(argv[i], "--profile") == 0) {
+            profile_enabled = 1;
+        } else if(strcmp(argv[i], "--spectate") == 0 && i + 1 < argc) {
+            spectate_path = argv[++i];
+        } else if(strcmp(argv[i], "--verify") == 0) {
+            // 뒤따르는 옵션이 아닌 인자는 전부 리플레이 파일
+            verify_first = i + 1;
+            while(i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+                i++;
+            verify_count = i + 1 - verify_first;
+            if(verify_count == 0) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    // TETRIS_PROFILE=1 도 --profile과 같다
+    profile_env = getenv("TETRIS_PROFILE");
+    if(profile_env && *profile_env && strcmp(profile_env, "0") != 0) {
+        profile_enabled = 1;
+    }
+    
+    if(verify_count > 0) {
+        return run_verify(verify_count, &argv[verify_first], threads);
+    }
+    
+    if(selfplay_games > 0) {
+        return run_selfplay(selfplay_games, threads,
+                            seed_given ? game_seed : pick_seed(), randomizer);
+    }
+    
+    // 예전 형식 기록 파일이면 새 형식으로 옮긴다 (--migrate는 옮기기만 하고 끝)
+    migrated = records_migrate();
+    if(migrated < 0) {
+        printf("Failed to migrate %s to the new record format\n", RESULT_FILE);
+    } else if(migrated > 0) {
+        printf("Migrated %ld records in %s (old file kept as %s.bak)\n",
+               migrated, RESULT_FILE, RESULT_FILE);
+    } else if(migrate_only) {
+        printf("%s is already in the current format\n", RESULT_FILE);
+    }
+    if(migrate_only) return migrated < 0 ? 1 : 0;
+    if(stats_only) return print_player_stats();
     
     // 플랫폼별 초기 설정
 #ifdef _WIN32
@@ -1299,6 +969,13 @@ int main(void) {
     printf("Platform: Unix\n");
 #endif
     
+    if(spectate_path != NULL) {
+        if(spectate_open(&spectator, spectate_path) == 0)
+            printf("Spectators can connect to %s\n", spectate_path);
+        else
+            printf("Could not open spectator socket %s\n", spectate_path);
+    }
+    
     // 플랫폼 정보 표기 Windows, Linux, mac Os
     SLEEP_MS(1000);
     
@@ -1308,7 +985,6 @@ int main(void) {
 
         switch(menu) {
             case 1:
-                game = GAME_START;
                 game_start();
                 break;
             case 2:
@@ -1319,6 +995,7 @@ int main(void) {
                 break;
             case 4:
                 printf("\n\t\t\tThank you for playing!\n");
+                spectate_close(&spectator);
                 SLEEP_MS(1000);
                 exit(0);
                 break;
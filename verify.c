@@ -0,0 +1,101 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "engine.h"
+#include "pool.h"
+#include "replay.h"
+#include "verify.h"
+
+#define VERIFY_MAX_FILE (16 * 1024 * 1024)  /* 이보다 큰 리플레이는 잘못된 파일로 본다 */
+
+struct verify_result {
+    int status;
+    long stored;
+    long replayed;
+};
+
+struct verify {
+    char **paths;
+    struct verify_result *results;
+};
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* 파일 하나를 통째로 읽어서 검증. 결과는 파일 번호 자리에 적는다 */
+static void verify_one(void *ctx, int worker, long job) {
+    struct verify *v = ctx;
+    struct verify_result *r = &v->results[job];
+    unsigned char *data;
+    long size;
+    FILE *fp;
+
+    (void)worker;
+    r->status = REPLAY_BAD;
+
+    fp = fopen(v->paths[job], "rb");
+    if(fp == NULL) return;
+
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if(size <= 0 || size > VERIFY_MAX_FILE) {
+        fclose(fp);
+        return;
+    }
+
+    data = malloc(size);
+    if(data != NULL && fread(data, 1, size, fp) == (size_t)size)
+        r->status = replay_verify(data, (size_t)size, &r->stored, &r->replayed);
+    free(data);
+    fclose(fp);
+}
+
+int run_verify(int count, char *paths[], int threads) {
+    struct verify v;
+    long ok = 0, mismatch = 0, bad = 0;
+    double start, elapsed;
+    int i;
+
+    if(count <= 0) return 1;
+
+    v.paths = paths;
+    v.results = calloc(count, sizeof(struct verify_result));
+    if(v.results == NULL) {
+        printf("Memory allocation failed!\n");
+        return 1;
+    }
+
+    start = now_sec();
+    threads = pool_run(count, threads, verify_one, &v);
+    elapsed = now_sec() - start;
+
+    /* 출력은 스레드가 다 끝난 뒤 파일 순서대로 */
+    for(i = 0; i < count; i++) {
+        struct verify_result *r = &v.results[i];
+        if(r->status == REPLAY_OK) {
+            ok++;
+        } else if(r->status == REPLAY_MISMATCH) {
+            mismatch++;
+            printf("MISMATCH %s: stored %ld, replayed %ld\n", paths[i], r->stored, r->replayed);
+        } else {
+            bad++;
+            printf("BAD %s: unreadable or truncated replay\n", paths[i]);
+        }
+    }
+    free(v.results);
+
+    if(elapsed <= 0) elapsed = 1e-9;
+    printf("verify: %d replays on %d threads\n", count, threads);
+    printf("ok: %ld, mismatch: %ld, bad: %ld\n", ok, mismatch, bad);
+    printf("elapsed: %.3f s\n", elapsed);
+    printf("replays/sec: %.1f\n", count / elapsed);
+
+    return (mismatch || bad) ? 1 : 0;
+}
@@ -0,0 +1,8 @@
+#ifndef TETRIS_VERIFY_H
+#define TETRIS_VERIFY_H
+
+/* 리플레이 파일들을 화면 없이 threads개 스레드로 다시 돌려 점수를 확인하고,
+ * 틀린 것만 출력한다. 모두 맞으면 0 */
+int run_verify(int count, char *paths[], int threads);
+
+#endif